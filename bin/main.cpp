@@ -1,24 +1,19 @@
 #include <lib/ArgParser.h>
+#include <lib/Completion.h>
 
 #include <functional>
 #include <iostream>
-#include <iterator>
 #include <numeric>
-#include <sstream>
 #include <string>
 #include <vector>
 
-
-std::vector<std::string> SplitString(const std::string& str) {
-    std::istringstream iss(str);
-
-    return {std::istream_iterator<std::string>(iss),
-            std::istream_iterator<std::string>()};
-}
-
 using namespace ArgumentParser;
 
 int main(int argc, char** argv) {
+    if (IsCompletionQuery(argc, argv)) {
+        return AnswerCompletion(argc, argv);
+    }
+
     ArgParser parser("My Parser");
     parser.AddHelp('h', "help", "Some Description about program");
     parser.AddStringArgument('i', "input", "File path for input file").MultiValue(1);
@@ -26,9 +21,14 @@ int main(int argc, char** argv) {
     parser.AddFlag('p', "flag2", "Use some logic");
     parser.AddIntArgument("numer", "Some Number");
 
-    parser.Parse(SplitString("app --help"));
+    if (IsCompletionIndexRequest(argc, argv)) {
+        return parser.WriteCompletionIndex(argv[2]) ? 0 : 1;
+    }
 
-    std::cout << parser.HelpDescription() << std::endl;
+    bool is_parsed = parser.Parse(argc, argv);
+    if (!is_parsed || parser.Help()) {
+        std::cout << parser.HelpDescription() << std::endl;
+    }
 
-    return 0;
+    return is_parsed ? 0 : 1;
 }
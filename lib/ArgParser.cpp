@@ -1,183 +1,551 @@
 #include "ArgParser.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+
+#include "Completion.h"
+#include "Constraints.h"
+#include "Parallel.h"
+#include "Suggestions.h"
+#include "Tokenizer.h"
+#include "Utf8.h"
+
 using namespace ArgumentParser;
 
+namespace {
+
+// Upper bound on threads reading prefetched files.
+constexpr size_t kMaxPrefetchThreads = 64;
+
+bool IsOption(std::string_view token) {
+    return !token.empty() && token[0] == '-';
+}
+
+}  // namespace
+
+ArgParser::ArgParser(const std::string& name) : name_(name) {
+    short_names_.fill(kNoArgument);
+}
+
+ArgParser::~ArgParser() {
+    for (auto& [name, argument] : arguments_) {
+        delete argument;
+    }
+    delete suggestion_index_;
+    delete constraints_;
+    delete command_line_;
+}
+
 bool ArgParser::Parse(int32_t argc, char** argv) {
-    std::vector<std::string> args = std::vector<std::string>(argv, argv + argc);
-    return Parse(args);
+    return Parse(ArgumentList(argc, argv), 1);
 }
 
 bool ArgParser::Parse(const std::vector<std::string>& args, int32_t index) {
-    if (index >= args.size()) {
-        BaseArgument* help = GetArgument("help");
-        if (help != nullptr) {
-            FlagArgument* flag_argument =
-                dynamic_cast<FlagArgument*>(help);
-            if (flag_argument != nullptr) {
-                return flag_argument->GetValue();
+    return Parse(ArgumentList(args), index);
+}
+
+bool ArgParser::Parse(std::vector<std::string>&& args, int32_t index) {
+    uint32_t positional = FindPositional();
+    if (positional == kNoArgument ||
+        !arguments_[positional].argument->is_lazy()) {
+        return Parse(ArgumentList(args), index);
+    }
+    // GetPositionalRange reads the arguments after Parse returns.
+    owned_args_ = std::move(args);
+    return Parse(ArgumentList(owned_args_), index);
+}
+
+bool ArgParser::Parse(std::span<const std::string_view> args, int32_t index) {
+    return Parse(ArgumentList(args), index);
+}
+
+bool ArgParser::Parse(const ArgumentList& args, size_t index) {
+    errors_.clear();
+    seen_.assign((arguments_.size() + 63) / 64, 0);
+    // Conversions may throw, so ranges of an earlier Parse can be left here.
+    positional_arguments_.clear();
+    for (auto& argument : arguments_) {
+        argument.argument->Reset();
+    }
+    // Only a lazy argument reads the arguments once Parse has returned.
+    uint32_t positional = FindPositional();
+    if (positional != kNoArgument &&
+        arguments_[positional].argument->is_lazy()) {
+        parsed_args_ = args;
+    } else {
+        parsed_args_ = ArgumentList();
+    }
+    parsed_begin_ = index;
+
+    size_t position = index;
+    while (position < args.size()) {
+        std::string_view token = args[position];
+        if (token.starts_with("--")) {
+            std::string_view name = token.substr(2);
+            size_t k = name.find('=');
+            uint32_t argument_index = FindArgument(name.substr(0, k));
+            if (argument_index == kNoArgument) {
+                std::vector<std::string> suggestions =
+                    Suggest(name.substr(0, k));
+                std::string message =
+                    "Unknown argument " + std::string(name.substr(0, k));
+                if (!suggestions.empty()) {
+                    message += ", did you mean --" + suggestions.front() + "?";
+                }
+                AddError(ParseError::Kind::kUnknownArgument, name.substr(0, k),
+                         message);
+                errors_.back().suggestions = std::move(suggestions);
+                return false;
+            }
+            MarkSeen(argument_index);
+            BaseArgument* argument = arguments_[argument_index].argument;
+            if (k != std::string_view::npos) {
+                argument->SetValue(name.substr(k + 1));
+            } else {
+                position = ConsumeValues(argument, args, position);
             }
+            ++position;
+            continue;
+        }
+
+        if (IsOption(token)) {
+            std::string_view names = token.substr(1);
+            size_t k = names.find('=');
+            for (char sname : names.substr(0, k)) {
+                uint32_t argument_index = FindArgument(sname);
+                if (argument_index == kNoArgument) {
+                    AddError(ParseError::Kind::kUnknownArgument,
+                             std::string_view(&sname, 1),
+                             std::string("Unknown argument ") + sname);
+                    return false;
+                }
+                MarkSeen(argument_index);
+                BaseArgument* argument = arguments_[argument_index].argument;
+                if (k != std::string_view::npos) {
+                    argument->SetValue(names.substr(k + 1));
+                } else {
+                    position = ConsumeValues(argument, args, position);
+                }
+            }
+            ++position;
+            continue;
+        }
+
+        size_t begin = position;
+        while (position < args.size() && !IsOption(args[position])) {
+            ++position;
         }
+        positional_arguments_.emplace_back(begin, position);
+    }
 
-        bool is_positional_correct = UpdatePositionalArguments();
-        positional_arguments_.clear();
-        if (!is_positional_correct) {
-            std::cerr << "Positional arguments are not correct" << std::endl;
+    if (dynamic_cast<FlagArgument*>(GetArgument("help")) != nullptr) {
+        return Help();
+    }
+
+    bool is_positional_correct = UpdatePositionalArguments(args);
+    if (!is_positional_correct) {
+        AddError(ParseError::Kind::kPositionalArguments, "",
+                 "Positional arguments are not correct");
+        return false;
+    }
+
+    for (auto& argument : arguments_) {
+        if (argument.argument->is_invalid()) {
+            AddError(ParseError::Kind::kRejectedValue, argument.name,
+                     DescribeRejection(
+                         *static_cast<StringArgument*>(argument.argument)));
             return false;
         }
+        if (!argument.argument->IsCorrect()) {
+            AddError(ParseError::Kind::kIncorrectArgument, argument.name,
+                     "Argument " + std::string(argument.name) +
+                         " is not correct");
+            return false;
+        }
+    }
 
-        for (auto& argument : arguments_) {
-            if (!argument.second->IsCorrect()) {
-                std::cerr << "Argument " << argument.first << " is not correct"
-                          << std::endl;
-                return false;
+    std::vector<size_t> violations;
+    if (constraints_ != nullptr) {
+        constraints_->Check(seen_, violations);
+    }
+    for (size_t rule : violations) {
+        AddError(ParseError::Kind::kConstraint,
+                 arguments_[constraints_->rules()[rule].arguments.front()].name,
+                 DescribeConstraint(rule));
+    }
+    return violations.empty() && PrefetchFiles();
+}
+
+bool ArgParser::PrefetchFiles() {
+    // (argument, value index)
+    std::vector<std::pair<const FileArgument*, int32_t>> files;
+    for (auto& argument : arguments_) {
+        if (argument.argument->is_prefetched()) {
+            auto* file_argument =
+                static_cast<const FileArgument*>(argument.argument);
+            int32_t count = file_argument->GetValues().size();
+            for (int32_t i = 0; i < count; ++i) {
+                files.emplace_back(file_argument, i);
             }
         }
+    }
+    if (files.empty()) {
         return true;
     }
 
-    if (args[index][0] == '-' && args[index][1] == '-') {
-        std::string name = args[index].substr(2);
-        size_t k = name.find('=');
-        if (k != std::string::npos) {
-            std::string value = name.substr(k + 1);
-            name = name.substr(0, k);
-            BaseArgument* argument = GetArgument(name);
-            if (argument == nullptr) {
-                std::cerr << "Unknown argument " << name << std::endl;
-                return false;
-            }
-            argument->SetValue(value);
-            return Parse(args, index + 1);
+    std::unique_ptr<bool[]> is_loaded(new bool[files.size()]);
+    size_t threads = std::min(files.size(), kMaxPrefetchThreads);
+    ParallelFor(files.size(), threads, [&](size_t i) {
+        is_loaded[i] = files[i].first->Load(files[i].second);
+    });
+    bool is_ok = true;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!is_loaded[i]) {
+            auto [argument, index] = files[i];
+            AddError(ParseError::Kind::kUnreadableFile, argument->name(),
+                     "Cannot read file " +
+                         std::string(argument->GetPath(index)) +
+                         " for argument " + std::string(argument->name()));
+            is_ok = false;
         }
-        BaseArgument* argument = GetArgument(name);
-        if (argument == nullptr) {
-            std::cerr << "Unknown argument " << name << std::endl;
-            return false;
+    }
+    return is_ok;
+}
+
+bool ArgParser::ParseCommandLine(std::string_view command_line) {
+    if (command_line_ == nullptr) {
+        command_line_ = new Tokenizer();
+    }
+    if (!command_line_->Tokenize(command_line)) {
+        errors_.clear();
+        AddError(ParseError::Kind::kMalformedCommandLine, "",
+                 "Unterminated quote or escape in command line");
+        return false;
+    }
+    return Parse(command_line_->args());
+}
+
+void ArgParser::MarkSeen(uint32_t index) {
+    seen_[index / 64] |= uint64_t(1) << (index % 64);
+}
+
+void ArgParser::AddError(ParseError::Kind kind, std::string_view argument,
+                         const std::string& message) {
+    std::fprintf(stderr, "%s\n", message.c_str());
+    errors_.push_back({kind, std::string(argument), message, {}});
+}
+
+size_t ArgParser::ValuesEnd(const ArgumentList& args, size_t index,
+                            size_t count) const {
+    size_t end = index + 1;
+    while (end < args.size() && !IsOption(args[end]) &&
+           end - index - 1 < count) {
+        ++end;
+    }
+    return end;
+}
+
+size_t ArgParser::ConsumeValues(BaseArgument* argument,
+                                const ArgumentList& args, size_t index) {
+    size_t count = argument->ValuesCount();
+    if (count == 0) {
+        argument->SetValue();
+        return index;
+    }
+    size_t end = ValuesEnd(args, index, count);
+    argument->SetValues(args.Slice(index + 1, end, values_buffer_), parallel_);
+    return end - 1;
+}
+
+size_t ArgParser::SkipOption(const ArgumentList& args, size_t index) const {
+    std::string_view token = args[index];
+    if (token.find('=') != std::string_view::npos) {
+        return index;
+    }
+    if (token.starts_with("--")) {
+        BaseArgument* argument = GetArgument(token.substr(2));
+        if (argument == nullptr || argument->ValuesCount() == 0) {
+            return index;
         }
-        int32_t count = argument->ValuesCount();
-        if (count == 0) {
-            argument->SetValue();
+        return ValuesEnd(args, index, argument->ValuesCount()) - 1;
+    }
+    for (char sname : token.substr(1)) {
+        uint32_t argument_index = FindArgument(sname);
+        if (argument_index == kNoArgument) {
+            continue;
         }
-        while (index + 1 < args.size() && args[index + 1][0] != '-' &&
-               count > 0) {
-            argument->SetValue(args[index + 1]);
-            ++index;
-            --count;
+        size_t count = arguments_[argument_index].argument->ValuesCount();
+        if (count != 0) {
+            index = ValuesEnd(args, index, count) - 1;
         }
-        return Parse(args, index + 1);
-    }
-
-    if (args[index][0] == '-') {
-        std::string names = args[index].substr(1);
-        size_t k = names.find('=');
-        if (k != std::string::npos) {
-            std::string value = names.substr(k + 1);
-            names = names.substr(0, k);
-            for (auto& sname : names) {
-                auto name = short_names_.find(sname);
-                if (name == short_names_.end()) {
-                    std::cerr << "Unknown argument " << sname << std::endl;
-                    return false;
-                }
-                BaseArgument* argument = GetArgument(name->second);
-                if (argument == nullptr) {
-                    std::cerr << "Unknown argument " << name->second
-                              << std::endl;
-                    return false;
-                }
-                argument->SetValue(value);
-            }
-            return Parse(args, index + 1);
+    }
+    return index;
+}
+
+size_t ArgParser::NextPositional(const ArgumentList& args,
+                                 size_t index) const {
+    while (index < args.size() && IsOption(args[index])) {
+        index = SkipOption(args, index) + 1;
+    }
+    return index;
+}
+
+bool ArgParser::UpdatePositionalArguments(const ArgumentList& args) {
+    if (positional_arguments_.empty()) {
+        return true;
+    }
+    uint32_t positional = FindPositional();
+    if (positional == kNoArgument) {
+        return false;
+    }
+    BaseArgument* argument = arguments_[positional].argument;
+    auto [begin, end] = positional_arguments_.front();
+    if (argument->is_lazy()) {
+        // Counted and validated only; GetPositionalRange yields the values.
+        auto* lazy = static_cast<StringArgument*>(argument);
+        for (size_t i = begin; lazy->is_checked() && i < end; ++i) {
+            lazy->CheckValue(args[i]);
         }
-        for (auto& sname : names) {
-            auto name = short_names_.find(sname);
-            if (name == short_names_.end()) {
-                std::cerr << "Unknown argument " << sname << std::endl;
-                return false;
-            }
-            BaseArgument* argument = GetArgument(name->second);
-            if (argument == nullptr) {
-                std::cerr << "Unknown argument " << name->second << std::endl;
-                return false;
-            }
-            int32_t count = argument->ValuesCount();
-            if (count == 0) {
-                argument->SetValue();
-            }
-            while (index + 1 < args.size() && args[index + 1][0] != '-' &&
-                   count > 0) {
-                argument->SetValue(args[index + 1]);
-                ++index;
-                --count;
-            }
+        lazy->SetLazyCount(end - begin);
+    } else {
+        argument->SetValues(args.Slice(begin, end, values_buffer_), parallel_);
+    }
+    MarkSeen(positional);
+    return positional_arguments_.size() == 1;
+}
+
+uint32_t ArgParser::FindPositional() const {
+    for (uint32_t i = 0; i < arguments_.size(); ++i) {
+        if (arguments_[i].argument->IsPositional()) {
+            return i;
         }
-        return Parse(args, index + 1);
     }
+    return kNoArgument;
+}
 
-    int32_t number = index;
-    while (index < args.size() && args[index][0] != '-') {
-        positional_arguments_.push_back(std::make_pair(number, args[index]));
-        ++index;
+PositionalRange ArgParser::GetPositionalRange(const std::string& name) const {
+    BaseArgument* argument = GetArgument(name);
+    if (argument == nullptr || !argument->is_lazy() ||
+        !argument->IsPositional()) {
+        throw std::runtime_error("Argument " + name +
+                                 " is not a lazy positional argument");
     }
+    return PositionalRange(this, parsed_args_, parsed_begin_);
+}
 
-    return Parse(args, index);
+PositionalRange::Iterator PositionalRange::begin() const {
+    return Iterator(parser_, args_, parser_->NextPositional(args_, begin_));
 }
 
-bool ArgParser::UpdatePositionalArguments() {
-    if (positional_arguments_.empty()) {
-        return true;
+PositionalRange::Iterator& PositionalRange::Iterator::operator++() {
+    position_ = parser_->NextPositional(args_, position_ + 1);
+    return *this;
+}
+
+ArgParser& ArgParser::ParallelConversion(size_t threshold, size_t threads) {
+    parallel_.threshold = threshold;
+    parallel_.threads = threads;
+    return *this;
+}
+
+uint32_t ArgParser::FindArgument(std::string_view name) const {
+    if (sorted_names_.size() != arguments_.size()) {
+        sorted_names_.resize(arguments_.size());
+        for (uint32_t i = 0; i < sorted_names_.size(); ++i) {
+            sorted_names_[i] = i;
+        }
+        std::stable_sort(sorted_names_.begin(), sorted_names_.end(),
+                         [this](uint32_t lhs, uint32_t rhs) {
+                             return arguments_[lhs].name <
+                                    arguments_[rhs].name;
+                         });
     }
-    int32_t index = 0;
-    for (auto& argument : arguments_) {
-        if (argument.second->IsPositional()) {
-            int32_t current = positional_arguments_[0].first;
-            while (index < positional_arguments_.size() &&
-                   positional_arguments_[index].first == current) {
-                argument.second->SetValue(positional_arguments_[index].second);
-                ++index;
-            }
+    auto it = std::lower_bound(sorted_names_.begin(), sorted_names_.end(),
+                               name,
+                               [this](uint32_t index, std::string_view key) {
+                                   return arguments_[index].name < key;
+                               });
+    if (it == sorted_names_.end() || arguments_[*it].name != name) {
+        return kNoArgument;
+    }
+    return *it;
+}
+
+uint32_t ArgParser::FindArgument(char short_name) const {
+    return short_names_[static_cast<unsigned char>(short_name)];
+}
+
+BaseArgument* ArgParser::GetArgument(std::string_view name) const {
+    uint32_t index = FindArgument(name);
+    if (index == kNoArgument) {
+        return nullptr;
+    }
+    return arguments_[index].argument;
+}
+
+std::vector<std::string> ArgParser::Suggest(std::string_view name,
+                                           size_t count) const {
+    if (suggestion_index_ == nullptr) {
+        suggestion_index_ = new SuggestionIndex();
+    }
+    if (suggestion_index_->size() != arguments_.size()) {
+        std::vector<std::string_view> names;
+        names.reserve(arguments_.size());
+        for (auto& argument : arguments_) {
+            names.push_back(argument.name);
         }
+        suggestion_index_->Build(names);
+    }
+    std::vector<std::string> suggestions;
+    for (uint32_t index : suggestion_index_->Suggest(name, count)) {
+        suggestions.emplace_back(arguments_[index].name);
     }
-    return index == positional_arguments_.size();
+    return suggestions;
 }
 
-BaseArgument* ArgParser::GetArgument(const std::string& name) const {
-    for (auto& argument : arguments_) {
-        if (argument.first == name) {
-            return argument.second;
+std::vector<uint32_t> ArgParser::FindConstrained(
+    const std::vector<std::string>& names) const {
+    std::vector<uint32_t> indices;
+    for (const std::string& name : names) {
+        uint32_t index = FindArgument(name);
+        if (index == kNoArgument) {
+            throw std::runtime_error("Constraint on unknown argument " + name);
         }
+        indices.push_back(index);
     }
-    return nullptr;
+    return indices;
 }
 
-FlagArgument& ArgParser::AddHelp(char short_name, const std::string& name,
+ConstraintSet& ArgParser::Constraints() {
+    if (constraints_ == nullptr) {
+        constraints_ = new ConstraintSet();
+    }
+    return *constraints_;
+}
+
+ArgParser& ArgParser::AddMutuallyExclusive(
+    const std::vector<std::string>& names) {
+    Constraints().Add(ConstraintSet::Kind::kMutuallyExclusive,
+                      FindConstrained(names));
+    return *this;
+}
+
+ArgParser& ArgParser::AddRequiredTogether(
+    const std::vector<std::string>& names) {
+    Constraints().Add(ConstraintSet::Kind::kRequiredTogether,
+                      FindConstrained(names));
+    return *this;
+}
+
+ArgParser& ArgParser::AddAtLeastOne(const std::vector<std::string>& names) {
+    Constraints().Add(ConstraintSet::Kind::kAtLeastOne,
+                      FindConstrained(names));
+    return *this;
+}
+
+ArgParser& ArgParser::AddDependency(const std::string& name,
+                                    const std::string& required) {
+    Constraints().Add(ConstraintSet::Kind::kRequires,
+                      FindConstrained({name, required}));
+    return *this;
+}
+
+std::string ArgParser::DescribeConstraint(size_t index) const {
+    const ConstraintSet::Rule& rule = constraints_->rules()[index];
+    if (rule.kind == ConstraintSet::Kind::kRequires) {
+        return "Argument --" +
+               std::string(arguments_[rule.arguments[0]].name) +
+               " requires --" +
+               std::string(arguments_[rule.arguments[1]].name);
+    }
+    std::string names;
+    for (uint32_t index : rule.arguments) {
+        names += names.empty() ? "--" : ", --";
+        names += arguments_[index].name;
+    }
+    if (rule.kind == ConstraintSet::Kind::kMutuallyExclusive) {
+        return "Arguments " + names + " are mutually exclusive";
+    }
+    if (rule.kind == ConstraintSet::Kind::kRequiredTogether) {
+        return "Arguments " + names + " must be used together";
+    }
+    return "At least one of " + names + " is required";
+}
+
+std::string ArgParser::DescribeRejection(
+    const StringArgument& argument) const {
+    std::string_view value = argument.rejected();
+    std::string message = "Value ";
+    if (argument.is_utf8() && !IsValidUtf8(value)) {
+        // Invalid bytes are escaped rather than sent to the terminal.
+        static constexpr char kHex[] = "0123456789abcdef";
+        message += '"';
+        for (unsigned char c : value) {
+            if (c < 0x20 || c >= 0x80) {
+                message += "\\x";
+                message += kHex[c >> 4];
+                message += kHex[c & 15];
+            } else {
+                message += static_cast<char>(c);
+            }
+        }
+        return message + "\" of argument " + std::string(argument.name()) +
+               " is not valid UTF-8";
+    }
+    std::string choices;
+    for (std::string_view choice : argument.choices()) {
+        choices += choices.empty() ? "" : ", ";
+        choices += choice;
+    }
+    return message + "\"" + std::string(value) + "\" of argument " +
+           std::string(argument.name()) + " is not one of " + choices;
+}
+
+template <typename Argument>
+Argument& ArgParser::AddArgument(char short_name, const std::string& name,
                                  const std::string& description) {
-    FlagArgument* argument = new FlagArgument(short_name, name, description);
-    arguments_.push_back(std::make_pair(name, argument));
-    short_names_.insert(std::make_pair(short_name, name));
+    Argument* argument =
+        new Argument(short_name, strings_.Add(name),
+                     descriptions_.Intern(strings_, description));
+    uint32_t index = arguments_.size();
+    arguments_.push_back({argument->name(), argument});
+    uint32_t& short_index = short_names_[static_cast<unsigned char>(short_name)];
+    if (short_name != '\0' && short_index == kNoArgument) {
+        short_index = index;
+    }
     return *argument;
 }
 
+FlagArgument& ArgParser::AddHelp(char short_name, const std::string& name,
+                                 const std::string& description) {
+    return AddArgument<FlagArgument>(short_name, name, description);
+}
+
 StringArgument& ArgParser::AddStringArgument(char short_name,
                                              const std::string& name,
                                              const std::string& description) {
-    StringArgument* argument =
-        new StringArgument(short_name, name, description);
-    arguments_.push_back(std::make_pair(name, argument));
-    short_names_.insert(std::make_pair(short_name, name));
-    return *argument;
+    return AddArgument<StringArgument>(short_name, name, description);
 }
 StringArgument& ArgParser::AddStringArgument(const std::string& name,
                                              const std::string& description) {
     return AddStringArgument('\0', name, description);
 }
 
+FileArgument& ArgParser::AddFileArgument(char short_name,
+                                         const std::string& name,
+                                         const std::string& description) {
+    return AddArgument<FileArgument>(short_name, name, description);
+}
+FileArgument& ArgParser::AddFileArgument(const std::string& name,
+                                         const std::string& description) {
+    return AddFileArgument('\0', name, description);
+}
+
 IntArgument& ArgParser::AddIntArgument(char short_name, const std::string& name,
                                        const std::string& description) {
-    IntArgument* argument = new IntArgument(short_name, name, description);
-    arguments_.push_back(std::make_pair(name, argument));
-    short_names_.insert(std::make_pair(short_name, name));
-    return *argument;
+    return AddArgument<IntArgument>(short_name, name, description);
 }
 IntArgument& ArgParser::AddIntArgument(const std::string& name,
                                        const std::string& description) {
@@ -186,10 +554,7 @@ IntArgument& ArgParser::AddIntArgument(const std::string& name,
 
 FlagArgument& ArgParser::AddFlag(char short_name, const std::string& name,
                                  const std::string& description) {
-    FlagArgument* argument = new FlagArgument(short_name, name, description);
-    arguments_.push_back(std::make_pair(name, argument));
-    short_names_.insert(std::make_pair(short_name, name));
-    return *argument;
+    return AddArgument<FlagArgument>(short_name, name, description);
 }
 FlagArgument& ArgParser::AddFlag(const std::string& name,
                                  const std::string& description) {
@@ -209,6 +574,36 @@ std::string ArgParser::GetStringValue(const std::string& name, int32_t index) {
     return string_argument->GetValue(index);
 }
 
+std::string_view ArgParser::GetStringView(const std::string& name,
+                                         int32_t index) const {
+    StringArgument* string_argument =
+        dynamic_cast<StringArgument*>(GetArgument(name));
+    if (string_argument == nullptr) {
+        return {};
+    }
+    return string_argument->GetView(index);
+}
+
+std::span<const std::string_view> ArgParser::GetStringValues(
+    const std::string& name) const {
+    StringArgument* string_argument =
+        dynamic_cast<StringArgument*>(GetArgument(name));
+    if (string_argument == nullptr) {
+        return {};
+    }
+    return string_argument->GetValues();
+}
+
+std::string_view ArgParser::GetFileContents(const std::string& name,
+                                           int32_t index) const {
+    FileArgument* file_argument =
+        dynamic_cast<FileArgument*>(GetArgument(name));
+    if (file_argument == nullptr) {
+        return {};
+    }
+    return file_argument->GetContents(index);
+}
+
 int32_t ArgParser::GetIntValue(const std::string& name, int32_t index) {
     BaseArgument* argument = GetArgument(name);
     if (argument == nullptr) {
@@ -249,34 +644,150 @@ std::string ArgParser::HelpDescription() const {
     std::string description = name_ + "\n";
     BaseArgument* help = GetArgument("help");
     if (help != nullptr) {
-        description += help->description() + "\n";
+        description += help->description();
+        description += "\n";
     }
     description += "Options:\n";
+
+    // (names column, details column)
+    std::vector<std::pair<std::string, std::string>> rows;
+    size_t names_width = 0;
     for (auto& [name, argument] : arguments_) {
         if (name == "help") {
             continue;
         }
 
+        std::string names = "    ";
         if (argument->short_name() != '\0') {
-            description += "-" + std::string(1, argument->short_name()) + ", ";
-        }
-        description += "--" + argument->name();
-        if (argument->description() != "") {
-            description += ", " + argument->description();
+            names = "-" + std::string(1, argument->short_name()) + ", ";
         }
+        names += "--";
+        names += name;
+        names_width = std::max(names_width, DisplayWidth(names));
 
+        std::string details(argument->description());
+        auto append = [&details](const std::string& detail) {
+            details += details.empty() ? detail : ", " + detail;
+        };
         if (argument->IsPositional()) {
-            description += ", (positional)";
+            append("(positional)");
         }
         if (argument->IsMultiValue()) {
-            description += ", (minimum " +
-                           std::to_string(argument->ValuesCount()) + " args)";
+            append("(minimum " + std::to_string(argument->ValuesCount()) +
+                   " args)");
         }
-        if(argument->GetDefaultValue() != "") {
-            description += ", (default " + argument->GetDefaultValue() + ")";
+        if (argument->GetDefaultValue() != "") {
+            append("(default " + argument->GetDefaultValue() + ")");
+        }
+        auto* string_argument = dynamic_cast<StringArgument*>(argument);
+        if (string_argument != nullptr &&
+            !string_argument->choices().empty()) {
+            std::string choices;
+            for (std::string_view choice : string_argument->choices()) {
+                choices += choices.empty() ? "" : ", ";
+                choices += choice;
+            }
+            append("(one of " + choices + ")");
+        }
+        rows.emplace_back(std::move(names), std::move(details));
+    }
+    for (auto& [names, details] : rows) {
+        description += names;
+        if (!details.empty()) {
+            size_t padding = names_width - DisplayWidth(names) + 2;
+            description += std::string(padding, ' ');
+            description += details;
         }
-
         description += "\n";
     }
+
+    if (constraints_ != nullptr && !constraints_->rules().empty()) {
+        description += "Constraints:\n";
+        for (size_t rule = 0; rule < constraints_->rules().size(); ++rule) {
+            description += DescribeConstraint(rule) + "\n";
+        }
+    }
+    if (!errors_.empty()) {
+        description += "Errors:\n";
+        for (const ParseError& error : errors_) {
+            description += error.message + "\n";
+        }
+    }
     return description;
+}
+
+std::string ArgParser::CompletionIndex() const {
+    std::vector<std::string> lines;
+    auto add = [&lines](std::string candidate, std::string_view description) {
+        candidate += '\t';
+        for (char c : description) {
+            candidate += c == '\n' || c == '\t' ? ' ' : c;
+        }
+        lines.push_back(std::move(candidate));
+    };
+    for (auto& [name, argument] : arguments_) {
+        std::string option = "--" + std::string(name);
+        add(option, argument->description());
+        if (argument->short_name() != '\0') {
+            add("-" + std::string(1, argument->short_name()),
+                argument->description());
+        }
+        auto* string_argument = dynamic_cast<StringArgument*>(argument);
+        if (string_argument != nullptr) {
+            for (std::string_view choice : string_argument->choices()) {
+                add(option + "=" + std::string(choice),
+                    argument->description());
+            }
+        }
+    }
+    std::sort(lines.begin(), lines.end());
+
+    std::string index;
+    for (const std::string& line : lines) {
+        index += line;
+        index += '\n';
+    }
+    return index;
+}
+
+bool ArgParser::WriteCompletionIndex(const std::string& path) const {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    std::string index = CompletionIndex();
+    bool is_ok = std::fwrite(index.data(), 1, index.size(), file) ==
+                 index.size();
+    return std::fclose(file) == 0 && is_ok;
+}
+
+std::string ArgParser::CompletionScript(Shell shell, const std::string& program,
+                                        const std::string& index_path) const {
+    bool has_positional = std::any_of(
+        arguments_.begin(), arguments_.end(),
+        [](const ArgumentDescriptor& argument) {
+            return argument.argument->IsPositional();
+        });
+    return ArgumentParser::CompletionScript(shell, program, index_path,
+                                            has_positional);
+}
+
+size_t ArgParser::MemoryFootprint() const {
+    size_t size = sizeof(ArgParser) + name_.capacity() + strings_.capacity() +
+                  descriptions_.capacity() +
+                  arguments_.capacity() * sizeof(ArgumentDescriptor) +
+                  sorted_names_.capacity() * sizeof(uint32_t);
+    if (suggestion_index_ != nullptr) {
+        size += suggestion_index_->Footprint();
+    }
+    if (constraints_ != nullptr) {
+        size += constraints_->Footprint();
+    }
+    if (command_line_ != nullptr) {
+        size += command_line_->Footprint();
+    }
+    for (auto& [name, argument] : arguments_) {
+        size += argument->Footprint();
+    }
+    return size;
 }
\ No newline at end of file
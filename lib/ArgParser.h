@@ -1,24 +1,108 @@
 #pragma once
 
+#include <array>
 #include <cinttypes>
-#include <iostream>
-#include <map>
+#include <iterator>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "ArgumentList.h"
 #include "Arguments.hpp"
+#include "StringPool.hpp"
 
 namespace ArgumentParser {
 
-class ArgParser {
+class ArgParser;
+class ConstraintSet;
+class SuggestionIndex;
+class Tokenizer;
+enum class Shell;
+
+// Positional tokens of a lazy argument, read straight from the arguments
+// passed to Parse, which must outlive the range. Iteration skips options
+// the same way Parse does and keeps no state beyond the current position.
+class PositionalRange {
    public:
-    ArgParser(const std::string& name) : name_(name) {}
+    class Iterator {
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view*;
+        using reference = std::string_view;
+
+        Iterator() = default;
+        Iterator(const ArgParser* parser, ArgumentList args, size_t position)
+            : parser_(parser), args_(args), position_(position) {}
+
+        std::string_view operator*() const { return args_[position_]; }
+        Iterator& operator++();
+        Iterator operator++(int) {
+            Iterator iterator = *this;
+            ++*this;
+            return iterator;
+        }
 
-    ~ArgParser() {
-        for (auto& [name, argument] : arguments_) {
-            delete argument;
+        bool operator==(const Iterator& other) const {
+            return position_ == other.position_;
+        }
+        bool operator==(std::default_sentinel_t) const {
+            return position_ >= args_.size();
         }
-    }
+
+       private:
+        const ArgParser* parser_ = nullptr;
+        ArgumentList args_;
+        size_t position_ = 0;
+    };
+
+    PositionalRange() = default;
+    PositionalRange(const ArgParser* parser, ArgumentList args, size_t begin)
+        : parser_(parser), args_(args), begin_(begin) {}
+
+    Iterator begin() const;
+    std::default_sentinel_t end() const { return {}; }
+
+   private:
+    const ArgParser* parser_ = nullptr;
+    ArgumentList args_;
+    size_t begin_ = 0;
+};
+
+struct ArgumentDescriptor {
+    std::string_view name;
+    BaseArgument* argument;
+};
+
+struct ParseError {
+    enum class Kind {
+        kUnknownArgument,
+        kMalformedCommandLine,
+        kPositionalArguments,
+        kIncorrectArgument,
+        kConstraint,
+        kUnreadableFile,
+        // A value failed Utf8() or Choices() validation.
+        kRejectedValue,
+    };
+
+    Kind kind;
+    // Offending argument name, empty when the error is not about one.
+    std::string argument;
+    std::string message;
+    // Closest known names for kUnknownArgument, nearest first.
+    std::vector<std::string> suggestions;
+};
+
+class ArgParser {
+   public:
+    ArgParser(const std::string& name);
+    ArgParser(const ArgParser&) = delete;
+    ArgParser& operator=(const ArgParser&) = delete;
+
+    ~ArgParser();
 
     // AddHelp
     FlagArgument& AddHelp(char short_name, const std::string& name,
@@ -30,6 +114,12 @@ class ArgParser {
     StringArgument& AddStringArgument(const std::string& name,
                                      const std::string& description = "");
 
+    // AddFileArgument
+    FileArgument& AddFileArgument(char short_name, const std::string& name,
+                                  const std::string& description = "");
+    FileArgument& AddFileArgument(const std::string& name,
+                                  const std::string& description = "");
+
     // AddIntArgument
     IntArgument& AddIntArgument(char short_name, const std::string& name,
                                const std::string& description = "");
@@ -44,26 +134,117 @@ class ArgParser {
 
     // Get
     std::string GetStringValue(const std::string& name, int32_t index = 0);
+    std::string_view GetStringView(const std::string& name,
+                                   int32_t index = 0) const;
+    std::span<const std::string_view> GetStringValues(
+        const std::string& name) const;
+    std::string_view GetFileContents(const std::string& name,
+                                     int32_t index = 0) const;
     int32_t GetIntValue(const std::string& name, int32_t index = 0);
     bool GetFlag(const std::string& name, int32_t index = 0);
 
     // Parse
+    //
+    // With a Lazy() positional argument the parser keeps a view of args for
+    // GetPositionalRange, so they must outlive its use; an rvalue vector is
+    // moved into the parser instead.
     bool Parse(int32_t argc, char** argv);
     bool Parse(const std::vector<std::string>& args, int32_t index = 1);
-    bool UpdatePositionalArguments();
-    BaseArgument* GetArgument(const std::string& name) const;
+    bool Parse(std::vector<std::string>&& args, int32_t index = 1);
+    bool Parse(std::span<const std::string_view> args, int32_t index = 1);
+    bool ParseCommandLine(std::string_view command_line);
+    bool UpdatePositionalArguments(const ArgumentList& args);
+    BaseArgument* GetArgument(std::string_view name) const;
+
+    // Positional tokens of a Lazy() positional argument from the last Parse.
+    PositionalRange GetPositionalRange(const std::string& name) const;
+
+    // Constraints, checked after every Parse. Unknown names throw.
+    ArgParser& AddMutuallyExclusive(const std::vector<std::string>& names);
+    ArgParser& AddRequiredTogether(const std::vector<std::string>& names);
+    ArgParser& AddAtLeastOne(const std::vector<std::string>& names);
+    ArgParser& AddDependency(const std::string& name,
+                             const std::string& required);
+
+    // Registered names closest to name, nearest first.
+    std::vector<std::string> Suggest(std::string_view name,
+                                     size_t count = 3) const;
+
+    // Errors of the last Parse
+    const std::vector<ParseError>& Errors() const { return errors_; }
+
+    // Converts value runs of at least threshold values on a thread pool.
+    ArgParser& ParallelConversion(size_t threshold = 64 * 1024,
+                                  size_t threads = 0);
 
     // Help
     std::string HelpDescription() const;
     bool Help() const;
 
+    // Completion
+    // Sorted "candidate<TAB>description" lines for every option, short name
+    // and "--name=choice". WriteCompletionIndex stores them for
+    // AnswerCompletion, which then needs no ArgParser at all.
+    std::string CompletionIndex() const;
+    bool WriteCompletionIndex(const std::string& path) const;
+    std::string CompletionScript(Shell shell, const std::string& program,
+                                 const std::string& index_path) const;
+
+    // Memory
+    size_t MemoryFootprint() const;
+
    private:
-    std::string name_ = "";
+    friend class PositionalRange;
+    friend class PositionalRange::Iterator;
+
+    static constexpr uint32_t kNoArgument = UINT32_MAX;
+
+    bool Parse(const ArgumentList& args, size_t index);
+    size_t ValuesEnd(const ArgumentList& args, size_t index,
+                     size_t count) const;
+    size_t SkipOption(const ArgumentList& args, size_t index) const;
+    size_t NextPositional(const ArgumentList& args, size_t index) const;
+    uint32_t FindPositional() const;
+
+    template <typename Argument>
+    Argument& AddArgument(char short_name, const std::string& name,
+                          const std::string& description);
+    uint32_t FindArgument(std::string_view name) const;
+    uint32_t FindArgument(char short_name) const;
+    std::vector<uint32_t> FindConstrained(
+        const std::vector<std::string>& names) const;
+    ConstraintSet& Constraints();
+    std::string DescribeConstraint(size_t index) const;
+    std::string DescribeRejection(const StringArgument& argument) const;
+    void MarkSeen(uint32_t index);
+    bool PrefetchFiles();
+    void AddError(ParseError::Kind kind, std::string_view argument,
+                  const std::string& message);
+    size_t ConsumeValues(BaseArgument* argument, const ArgumentList& args,
+                         size_t index);
 
-    std::vector<std::pair<std::string, BaseArgument*>> arguments_;
-    std::map<char, std::string> short_names_;
+    std::string name_ = "";
 
-    std::vector<std::pair<int32_t, std::string>> positional_arguments_;
+    StringPool strings_;
+    StringInterner descriptions_;
+    std::vector<ArgumentDescriptor> arguments_;
+    std::array<uint32_t, 256> short_names_;
+    mutable std::vector<uint32_t> sorted_names_;
+    // Built on first use, so programs that never need them do not pay for
+    // them at startup.
+    mutable SuggestionIndex* suggestion_index_ = nullptr;
+
+    ConstraintSet* constraints_ = nullptr;
+    std::vector<uint64_t> seen_;
+    std::vector<ParseError> errors_;
+
+    ParallelOptions parallel_;
+    std::vector<std::string_view> values_buffer_;
+    std::vector<std::pair<size_t, size_t>> positional_arguments_;
+    Tokenizer* command_line_ = nullptr;
+    std::vector<std::string> owned_args_;
+    ArgumentList parsed_args_;
+    size_t parsed_begin_ = 0;
 };
 
 }  // namespace ArgumentParser
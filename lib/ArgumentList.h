@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cinttypes>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ArgumentParser {
+
+// Non-owning view over command line arguments, whether they come from argv,
+// a vector of strings or already split string_views. Copying it is O(1).
+class ArgumentList {
+   public:
+    ArgumentList() = default;
+    ArgumentList(int32_t argc, const char* const* argv)
+        : data_(argv), size_(argc), kind_(Kind::kArgv) {}
+    ArgumentList(std::span<const std::string> args)
+        : data_(args.data()), size_(args.size()), kind_(Kind::kStrings) {}
+    ArgumentList(std::span<const std::string_view> args)
+        : data_(args.data()), size_(args.size()), kind_(Kind::kViews) {}
+
+    size_t size() const { return size_; }
+
+    std::string_view operator[](size_t index) const {
+        switch (kind_) {
+            case Kind::kArgv:
+                return static_cast<const char* const*>(data_)[index];
+            case Kind::kStrings:
+                return static_cast<const std::string*>(data_)[index];
+            case Kind::kViews:
+                break;
+        }
+        return static_cast<const std::string_view*>(data_)[index];
+    }
+
+    // Returns [begin, end) as string_views, using buffer when the arguments
+    // are not stored as string_views already.
+    std::span<const std::string_view> Slice(
+        size_t begin, size_t end, std::vector<std::string_view>& buffer) const {
+        if (kind_ == Kind::kViews) {
+            return std::span(static_cast<const std::string_view*>(data_) + begin,
+                             end - begin);
+        }
+        buffer.clear();
+        for (size_t i = begin; i < end; ++i) {
+            buffer.push_back((*this)[i]);
+        }
+        return buffer;
+    }
+
+   private:
+    enum class Kind : uint8_t { kArgv, kStrings, kViews };
+
+    const void* data_ = nullptr;
+    size_t size_ = 0;
+    Kind kind_ = Kind::kViews;
+};
+
+}  // namespace ArgumentParser
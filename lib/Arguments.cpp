@@ -0,0 +1,391 @@
+#include "Arguments.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+#include "MappedFile.h"
+#include "Parallel.h"
+#include "Utf8.h"
+
+using namespace ArgumentParser;
+
+namespace {
+
+// Values converted per ParallelFor task.
+constexpr size_t kParallelChunkSize = 16 * 1024;
+
+}  // namespace
+
+std::errc ArgumentParser::ParseInt(std::string_view value, int32_t& result) {
+    size_t begin = 0;
+    while (begin < value.size() &&
+           std::isspace(static_cast<unsigned char>(value[begin]))) {
+        ++begin;
+    }
+    if (begin + 1 < value.size() && value[begin] == '+' &&
+        value[begin + 1] != '-') {
+        ++begin;
+    }
+    return std::from_chars(value.data() + begin, value.data() + value.size(),
+                           result)
+        .ec;
+}
+
+int32_t ArgumentParser::ParseInt(std::string_view value) {
+    int32_t result = 0;
+    std::errc error = ParseInt(value, result);
+    if (error == std::errc::invalid_argument) {
+        throw std::invalid_argument("stoi");
+    }
+    if (error == std::errc::result_out_of_range) {
+        throw std::out_of_range("stoi");
+    }
+    return result;
+}
+
+// Base argument
+void BaseArgument::SetValues(std::span<const std::string_view> values,
+                             const ParallelOptions&) {
+    for (std::string_view value : values) {
+        SetValue(value);
+    }
+}
+
+int32_t BaseArgument::ValuesCount() const {
+    if (Has(kMultiValue)) {
+        if (multi_value_count_ != 0) {
+            return multi_value_count_;
+        }
+        return std::numeric_limits<int32_t>::max();
+    }
+    return 1;
+}
+
+// Int argument
+IntArgument::~IntArgument() {
+    if (Has(kStored)) {
+        return;
+    }
+    delete value_;
+    delete multi_value_;
+}
+
+void IntArgument::SetValue(std::string_view value) {
+    if (Has(kMultiValue)) {
+        if (multi_value_ == nullptr) {
+            multi_value_ = new std::vector<int32_t>();
+        }
+        multi_value_->push_back(ParseInt(value));
+    } else {
+        if (value_ == nullptr) {
+            value_ = new int32_t();
+        }
+        *value_ = ParseInt(value);
+    }
+    Set(kSet);
+}
+
+void IntArgument::SetValues(std::span<const std::string_view> values,
+                            const ParallelOptions& parallel) {
+    if (!Has(kMultiValue) || parallel.threshold == 0 ||
+        values.size() < parallel.threshold) {
+        BaseArgument::SetValues(values, parallel);
+        return;
+    }
+    if (multi_value_ == nullptr) {
+        multi_value_ = new std::vector<int32_t>();
+    }
+    size_t offset = multi_value_->size();
+    multi_value_->resize(offset + values.size());
+    int32_t* result = multi_value_->data() + offset;
+    std::atomic<size_t> first_error = values.size();
+    size_t chunks =
+        (values.size() + kParallelChunkSize - 1) / kParallelChunkSize;
+    ParallelFor(chunks, parallel.threads, [&](size_t chunk) {
+        size_t end = std::min(values.size(), (chunk + 1) * kParallelChunkSize);
+        for (size_t i = chunk * kParallelChunkSize; i < end; ++i) {
+            if (ParseInt(values[i], result[i]) != std::errc()) {
+                size_t error = first_error.load();
+                while (i < error &&
+                       !first_error.compare_exchange_weak(error, i)) {
+                }
+                return;
+            }
+        }
+    });
+    Set(kSet);
+    if (first_error < values.size()) {
+        multi_value_->resize(offset + first_error);
+        ParseInt(values[first_error]);
+    }
+}
+
+bool IntArgument::IsCorrect() const {
+    if (Has(kMultiValue)) {
+        return !(ValuesSize() < static_cast<size_t>(multi_value_count_) &&
+                 multi_value_count_ != 0);
+    }
+    return Has(kSet) || Has(kDefault);
+}
+
+std::string IntArgument::GetDefaultValue() const {
+    if (Has(kDefault) && !Has(kMultiValue)) {
+        return std::to_string(default_value_);
+    }
+    return "";
+}
+
+size_t IntArgument::Footprint() const {
+    size_t size = sizeof(IntArgument) +
+                  default_multi_value_.capacity() * sizeof(int32_t);
+    if (!Has(kStored)) {
+        if (value_ != nullptr) {
+            size += sizeof(int32_t);
+        }
+        if (multi_value_ != nullptr) {
+            size += sizeof(*multi_value_) +
+                    multi_value_->capacity() * sizeof(int32_t);
+        }
+    }
+    return size;
+}
+
+// String argument
+StringArgument::~StringArgument() {
+    delete choices_;
+}
+
+void StringArgument::SetValue(std::string_view value) {
+    CheckValue(value);
+    std::string_view view = values_.Add(value);
+    if (Has(kMultiValue)) {
+        views_.push_back(view);
+        if (multi_value_ != nullptr) {
+            multi_value_->emplace_back(value);
+        }
+    } else {
+        views_.assign(1, view);
+        if (value_ != nullptr) {
+            *value_ = value;
+        }
+    }
+    Set(kSet);
+}
+
+void StringArgument::SetValues(std::span<const std::string_view> values,
+                               const ParallelOptions& parallel) {
+    if (!Has(kMultiValue) || parallel.threshold == 0 ||
+        values.size() < parallel.threshold) {
+        BaseArgument::SetValues(values, parallel);
+        return;
+    }
+    std::vector<size_t> offsets(values.size() + 1, 0);
+    for (size_t i = 0; i < values.size(); ++i) {
+        offsets[i + 1] = offsets[i] + values[i].size();
+    }
+    char* data = values_.Allocate(offsets.back());
+    size_t views_offset = views_.size();
+    views_.resize(views_offset + values.size());
+    size_t stored_offset = 0;
+    if (multi_value_ != nullptr) {
+        stored_offset = multi_value_->size();
+        multi_value_->resize(stored_offset + values.size());
+    }
+    std::atomic<size_t> first_invalid = values.size();
+    size_t chunks =
+        (values.size() + kParallelChunkSize - 1) / kParallelChunkSize;
+    ParallelFor(chunks, parallel.threads, [&](size_t chunk) {
+        size_t end = std::min(values.size(), (chunk + 1) * kParallelChunkSize);
+        for (size_t i = chunk * kParallelChunkSize; i < end; ++i) {
+            if (!IsAccepted(values[i])) {
+                size_t invalid = first_invalid.load();
+                while (i < invalid &&
+                       !first_invalid.compare_exchange_weak(invalid, i)) {
+                }
+            }
+            std::memcpy(data + offsets[i], values[i].data(), values[i].size());
+            views_[views_offset + i] =
+                std::string_view(data + offsets[i], values[i].size());
+            if (multi_value_ != nullptr) {
+                (*multi_value_)[stored_offset + i] = values[i];
+            }
+        }
+    });
+    if (first_invalid < values.size()) {
+        Reject(values[first_invalid]);
+    }
+    Set(kSet);
+}
+
+bool StringArgument::IsCorrect() const {
+    if (Has(kInvalid)) {
+        return false;
+    }
+    if (Has(kMultiValue)) {
+        size_t count = Has(kLazy) ? lazy_count_ : GetValues().size();
+        return !(count < static_cast<size_t>(multi_value_count_) &&
+                 multi_value_count_ != 0);
+    }
+    return Has(kSet) || Has(kDefault);
+}
+
+std::string StringArgument::GetDefaultValue() const {
+    if (Has(kDefault) && !Has(kMultiValue)) {
+        return std::string(default_views_.front());
+    }
+    return "";
+}
+
+size_t StringArgument::Footprint() const {
+    size_t choices = choices_ == nullptr
+                         ? 0
+                         : sizeof(*choices_) +
+                               choices_->capacity() * sizeof(std::string_view);
+    return sizeof(StringArgument) + strings_.capacity() + values_.capacity() +
+           choices +
+           (views_.capacity() + default_views_.capacity()) *
+               sizeof(std::string_view);
+}
+
+void StringArgument::Reset() {
+    BaseArgument::Reset();
+    attributes_ &= ~kSet;
+    values_.Reset();
+    views_.clear();
+    rejected_ = {};
+    lazy_count_ = 0;
+}
+
+StringArgument& StringArgument::Choices(
+    const std::vector<std::string>& choices) {
+    if (choices_ == nullptr) {
+        choices_ = new std::vector<std::string_view>();
+    }
+    for (const std::string& choice : choices) {
+        choices_->push_back(strings_.Add(choice));
+    }
+    return *this;
+}
+
+bool StringArgument::IsAccepted(std::string_view value) const {
+    if (Has(kUtf8) && !IsValidUtf8(value)) {
+        return false;
+    }
+    return choices_ == nullptr ||
+           std::find(choices_->begin(), choices_->end(), value) !=
+               choices_->end();
+}
+
+// File argument
+struct FileArgument::File {
+    std::once_flag once;
+    MappedFile mapping;
+    bool is_open = false;
+};
+
+struct FileArgument::Files {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<File>> loaded;
+};
+
+FileArgument::FileArgument() : files_(new Files()) {}
+FileArgument::FileArgument(char short_name, std::string_view name,
+                           std::string_view description)
+    : StringArgument(short_name, name, description), files_(new Files()) {}
+FileArgument::~FileArgument() {
+    delete files_;
+}
+
+void FileArgument::SetValue(std::string_view value) {
+    {
+        std::lock_guard<std::mutex> lock(files_->mutex);
+        files_->loaded.clear();
+    }
+    StringArgument::SetValue(value);
+}
+
+void FileArgument::SetValues(std::span<const std::string_view> values,
+                             const ParallelOptions& parallel) {
+    {
+        std::lock_guard<std::mutex> lock(files_->mutex);
+        files_->loaded.clear();
+    }
+    StringArgument::SetValues(values, parallel);
+}
+
+void FileArgument::Reset() {
+    {
+        std::lock_guard<std::mutex> lock(files_->mutex);
+        files_->loaded.clear();
+    }
+    StringArgument::Reset();
+}
+
+bool FileArgument::Load(int32_t index) const {
+    std::string_view path = GetPath(index);
+    File* file = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(files_->mutex);
+        std::vector<std::unique_ptr<File>>& loaded = files_->loaded;
+        if (loaded.size() <= static_cast<size_t>(index)) {
+            loaded.resize(index + 1);
+        }
+        if (loaded[index] == nullptr) {
+            loaded[index] = std::make_unique<File>();
+        }
+        file = loaded[index].get();
+    }
+    bool populate = Has(kPrefetch);
+    std::call_once(file->once, [file, path, populate] {
+        file->is_open = file->mapping.Open(std::string(path), populate);
+    });
+    return file->is_open;
+}
+
+std::string_view FileArgument::GetContents(int32_t index) const {
+    if (!Load(index)) {
+        throw std::runtime_error("Cannot read file " +
+                                 std::string(GetPath(index)));
+    }
+    std::lock_guard<std::mutex> lock(files_->mutex);
+    return files_->loaded[index]->mapping.contents();
+}
+
+// Flag argument
+FlagArgument::~FlagArgument() {
+    if (Has(kStored)) {
+        return;
+    }
+    delete value_;
+}
+
+void FlagArgument::SetValue(std::string_view value) {
+    if (value_ == nullptr) {
+        value_ = new bool();
+    }
+    if (value == "true" || value == "1") {
+        *value_ = true;
+    } else if (value == "false" || value == "0") {
+        *value_ = false;
+    } else {
+        *value_ = !Has(kDefault);
+    }
+    Set(kSet);
+}
+
+std::string FlagArgument::GetDefaultValue() const {
+    return Has(kDefault) ? "true" : "false";
+}
+
+size_t FlagArgument::Footprint() const {
+    if (value_ != nullptr && !Has(kStored)) {
+        return sizeof(FlagArgument) + sizeof(bool);
+    }
+    return sizeof(FlagArgument);
+}
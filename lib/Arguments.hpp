@@ -1,107 +1,111 @@
 #pragma once
 
 #include <cinttypes>
-#include <iostream>
-#include <limits>
-#include <map>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <vector>
 
+#include "StringPool.hpp"
+
 namespace ArgumentParser {
 
+// Parses the leading integer of value the way std::stoi does, without
+// allocating or throwing.
+std::errc ParseInt(std::string_view value, int32_t& result);
+// Same, but throws std::invalid_argument or std::out_of_range like stoi.
+int32_t ParseInt(std::string_view value);
+
+struct ParallelOptions {
+    // Value runs shorter than threshold are converted on the calling thread;
+    // zero disables parallel conversion.
+    size_t threshold = 0;
+    // Zero means std::thread::hardware_concurrency().
+    size_t threads = 0;
+};
+
 // Base argument
 class BaseArgument {
    public:
+    enum Attribute : uint16_t {
+        kPositional = 1 << 0,
+        kMultiValue = 1 << 1,
+        kDefault = 1 << 2,
+        kSet = 1 << 3,
+        kStored = 1 << 4,
+        kLazy = 1 << 5,
+        kPrefetch = 1 << 6,
+        kUtf8 = 1 << 7,
+        kInvalid = 1 << 8,
+    };
+
     virtual ~BaseArgument() = default;
     BaseArgument() = default;
-    BaseArgument(char short_name, const std::string& name,
-                 const std::string& description)
-        : short_name_(short_name), name_(name), description_(description) {}
+    BaseArgument(char short_name, std::string_view name,
+                 std::string_view description)
+        : name_(name), description_(description), short_name_(short_name) {}
 
-    std::string name() const { return name_; }
-    std::string description() const { return description_; }
+    std::string_view name() const { return name_; }
+    std::string_view description() const { return description_; }
     char short_name() const { return short_name_; }
 
-    virtual void SetValue(const std::string& value = "") = 0;
+    virtual void SetValue(std::string_view value = {}) = 0;
+    virtual void SetValues(std::span<const std::string_view> values,
+                           const ParallelOptions& parallel);
     virtual bool IsCorrect() const = 0;
-    virtual bool IsPositional() const { return false; }
-    virtual bool IsMultiValue() const { return false; }
-    virtual int32_t ValuesCount() const { return 1; }
+    virtual int32_t ValuesCount() const;
     virtual std::string GetDefaultValue() const { return ""; }
-
-   private:
-    std::string name_ = "";
-    std::string description_ = "";
+    virtual size_t Footprint() const { return sizeof(BaseArgument); }
+
+    bool IsPositional() const { return Has(kPositional); }
+    bool IsMultiValue() const { return Has(kMultiValue); }
+    bool is_default() const { return Has(kDefault); }
+    bool is_set() const { return Has(kSet); }
+    bool is_lazy() const { return Has(kLazy); }
+    bool is_prefetched() const { return Has(kPrefetch); }
+    bool is_utf8() const { return Has(kUtf8); }
+    bool is_invalid() const { return Has(kInvalid); }
+
+    // Called by Parse before new values arrive.
+    virtual void Reset() { attributes_ &= ~kInvalid; }
+
+   protected:
+    bool Has(Attribute attribute) const { return attributes_ & attribute; }
+    void Set(Attribute attribute) { attributes_ |= attribute; }
+
+    std::string_view name_;
+    std::string_view description_;
     char short_name_ = '\0';
+    uint16_t attributes_ = 0;
+    int32_t multi_value_count_ = 0;
 };
 
 // Int argument
 class IntArgument : public BaseArgument {
    public:
     IntArgument() = default;
-    IntArgument(char short_name, const std::string& name,
-                const std::string& description)
+    IntArgument(char short_name, std::string_view name,
+                std::string_view description)
         : BaseArgument(short_name, name, description) {}
-    ~IntArgument() {
-        if (is_stored_) {
-            return;
-        }
-        delete value_;
-        delete multi_value_;
-    }
+    ~IntArgument() override;
 
-    void SetValue(const std::string& value) override {
-        if (is_multi_value_) {
-            if (multi_value_ == nullptr) {
-                multi_value_ = new std::vector<int32_t>();
-            }
-            multi_value_->push_back(std::stoi(value));
-        } else {
-            if (value_ == nullptr) {
-                value_ = new int32_t();
-            }
-            *value_ = std::stoi(value);
-        }
-        is_set_ = true;
-    }
-
-    bool IsCorrect() const override {
-        if (is_multi_value_) {
-            return !(multi_value_->size() < multi_value_count_ &&
-                     multi_value_count_ != 0);
-        }
-        return is_set_ || is_default_;
-    }
-
-    bool IsPositional() const override { return is_positional_; }
-
-    bool IsMultiValue() const override { return is_multi_value_; }
-
-    int32_t ValuesCount() const override {
-        if (is_multi_value_) {
-            if (multi_value_count_ != 0) {
-                return multi_value_count_;
-            }
-            return std::numeric_limits<int32_t>::max();
-        }
-        return 1;
-    }
-
-    std::string GetDefaultValue() const override {
-        if (is_default_) {
-            return std::to_string(default_value_);
-        }
-        return "";
-    }
+    void SetValue(std::string_view value) override;
+    void SetValues(std::span<const std::string_view> values,
+                   const ParallelOptions& parallel) override;
+    bool IsCorrect() const override;
+    std::string GetDefaultValue() const override;
+    size_t Footprint() const override;
 
     int32_t GetValue(int32_t index = 0) const {
-        if (is_multi_value_) {
-            if (is_set_) {
+        if (Has(kMultiValue)) {
+            if (Has(kSet)) {
                 return multi_value_->at(index);
             }
             return default_multi_value_.at(index);
         } else {
-            if (is_set_) {
+            if (Has(kSet)) {
                 return *value_;
             }
             return default_value_;
@@ -109,266 +113,345 @@ class IntArgument : public BaseArgument {
     }
 
     IntArgument& Positional() {
-        is_positional_ = true;
+        Set(kPositional);
         return *this;
     }
 
     IntArgument& Default(int32_t value) {
-        if (is_multi_value_) {
+        if (Has(kMultiValue)) {
             throw std::runtime_error(
                 "Default value for multi value argument is not supported");
         }
         default_value_ = value;
-        is_default_ = true;
+        Set(kDefault);
         return *this;
     }
 
     IntArgument& Default(const std::vector<int32_t>& values) {
-        if (!is_multi_value_) {
+        if (!Has(kMultiValue)) {
             throw std::runtime_error(
                 "Default value for single value argument is not supported");
         }
         default_multi_value_ = values;
-        is_default_ = true;
+        Set(kDefault);
         return *this;
     }
 
     IntArgument& MultiValue(int32_t count = 0) {
         multi_value_count_ = count;
-        is_multi_value_ = true;
+        Set(kMultiValue);
         return *this;
     }
 
     IntArgument& StoreValue(int32_t& value) {
-        if (is_multi_value_) {
+        if (Has(kMultiValue)) {
             throw std::runtime_error(
                 "Store value for multi value argument is not supported");
         }
         value_ = &value;
-        is_stored_ = true;
+        Set(kStored);
         return *this;
     }
 
     IntArgument& StoreValues(std::vector<int32_t>& values) {
-        if (!is_multi_value_) {
+        if (!Has(kMultiValue)) {
             throw std::runtime_error(
                 "Store value for single value argument is not supported");
         }
         multi_value_ = &values;
-        is_stored_ = true;
+        Set(kStored);
         return *this;
     }
 
-    bool is_default() const { return is_default_; }
-
    private:
+    size_t ValuesSize() const {
+        if (Has(kSet)) {
+            return multi_value_->size();
+        }
+        return default_multi_value_.size();
+    }
+
     int32_t* value_ = nullptr;
     std::vector<int32_t>* multi_value_ = nullptr;
-    int32_t default_value_;
     std::vector<int32_t> default_multi_value_;
-
-    bool is_default_ = false;
-    int32_t multi_value_count_ = 0;
-    bool is_multi_value_ = false;
-    bool is_set_ = false;
-    bool is_positional_ = false;
-    bool is_stored_ = false;
+    int32_t default_value_ = 0;
 };
 
 // String argument
+//
+// Parsed values are kept in an arena owned by the argument, so the views
+// returned by GetView and GetValues stay valid until the next Parse, which
+// reuses the arena. Defaults and choices live in a separate pool for as long
+// as the argument (and thus its ArgParser) lives.
 class StringArgument : public BaseArgument {
    public:
     StringArgument() = default;
-    StringArgument(char short_name, const std::string& name,
-                   const std::string& description)
+    StringArgument(char short_name, std::string_view name,
+                   std::string_view description)
         : BaseArgument(short_name, name, description) {}
-    ~StringArgument() {
-        if (is_stored_) {
-            return;
-        }
-        delete value_;
-        delete multi_value_;
+    ~StringArgument() override;
+
+    void SetValue(std::string_view value) override;
+    void SetValues(std::span<const std::string_view> values,
+                   const ParallelOptions& parallel) override;
+    bool IsCorrect() const override;
+    std::string GetDefaultValue() const override;
+    size_t Footprint() const override;
+    // Drops the values of the previous Parse.
+    void Reset() override;
+
+    std::string GetValue(int32_t index = 0) const {
+        return std::string(GetView(index));
     }
 
-    void SetValue(const std::string& value) override {
-        if (is_multi_value_) {
-            if (multi_value_ == nullptr) {
-                multi_value_ = new std::vector<std::string>();
-            }
-            multi_value_->push_back(value);
-        } else {
-            if (value_ == nullptr) {
-                value_ = new std::string();
-            }
-            *value_ = value;
+    // A single value ignores index and is empty when neither set nor
+    // defaulted, as GetValue always was.
+    std::string_view GetView(int32_t index = 0) const {
+        std::span<const std::string_view> values = GetValues();
+        if (!Has(kMultiValue)) {
+            return values.empty() ? std::string_view() : values.front();
+        }
+        if (index < 0 || static_cast<size_t>(index) >= values.size()) {
+            throw std::out_of_range("String argument index is out of range");
         }
-        is_set_ = true;
+        return values[index];
     }
 
-    bool IsCorrect() const override {
-        if (is_multi_value_) {
-            return !(multi_value_->size() < multi_value_count_ &&
-                     multi_value_count_ != 0);
+    std::span<const std::string_view> GetValues() const {
+        if (Has(kSet)) {
+            return views_;
         }
-        return is_set_ || is_default_;
+        return default_views_;
     }
 
-    bool IsPositional() const override { return is_positional_; }
+    StringArgument& Positional() {
+        Set(kPositional);
+        return *this;
+    }
 
-    bool IsMultiValue() const override { return is_multi_value_; }
+    // A lazy positional argument accepts the same tokens as any other, but
+    // Parse only counts them; read them with ArgParser::GetPositionalRange.
+    StringArgument& Lazy() {
+        Set(kLazy);
+        return *this;
+    }
 
-    int32_t ValuesCount() const override {
-        if (is_multi_value_) {
-            if (multi_value_count_ != 0) {
-                return multi_value_count_;
-            }
-            return std::numeric_limits<int32_t>::max();
-        }
-        return 1;
+    // Rejects values that are not valid UTF-8, including positional ones.
+    StringArgument& Utf8() {
+        Set(kUtf8);
+        return *this;
     }
 
-    std::string GetDefaultValue() const override { 
-        if (is_default_) {
-            return default_value_;
+    // Rejects values other than the given ones; shell completion offers
+    // them as "--name=choice".
+    StringArgument& Choices(const std::vector<std::string>& choices);
+
+    std::span<const std::string_view> choices() const {
+        if (choices_ == nullptr) {
+            return {};
         }
-        return "";
+        return *choices_;
     }
 
-    std::string GetValue(int32_t index = 0) const {
-        if (is_multi_value_) {
-            if (is_set_) {
-                return multi_value_->at(index);
-            }
-            return default_multi_value_.at(index);
-        } else {
-            if (is_set_) {
-                return *value_;
-            }
-            return default_value_;
+    bool is_checked() const { return Has(kUtf8) || choices_ != nullptr; }
+
+    bool IsAccepted(std::string_view value) const;
+
+    void CheckValue(std::string_view value) {
+        if (!IsAccepted(value)) {
+            Reject(value);
         }
     }
 
-    StringArgument& Positional() {
-        is_positional_ = true;
-        return *this;
+    // First value rejected by CheckValue since the last Reset.
+    std::string_view rejected() const { return rejected_; }
+
+    void SetLazyCount(size_t count) {
+        lazy_count_ = count;
+        if (count != 0) {
+            Set(kSet);
+        }
     }
 
     StringArgument& Default(const std::string& value) {
-        if (is_multi_value_) {
+        if (Has(kMultiValue)) {
             throw std::runtime_error(
                 "Default value for multi value argument is not supported");
         }
-        default_value_ = value;
-        is_default_ = true;
+        default_views_.assign(1, strings_.Add(value));
+        Set(kDefault);
         return *this;
     }
 
     StringArgument& Default(const std::vector<std::string>& values) {
-        if (!is_multi_value_) {
+        if (!Has(kMultiValue)) {
             throw std::runtime_error(
                 "Default value for single value argument is not supported");
         }
-        default_multi_value_ = values;
-        is_default_ = true;
+        default_views_.clear();
+        for (const std::string& value : values) {
+            default_views_.push_back(strings_.Add(value));
+        }
+        Set(kDefault);
         return *this;
     }
 
     StringArgument& MultiValue(int32_t count = 0) {
         multi_value_count_ = count;
-        is_multi_value_ = true;
+        Set(kMultiValue);
         return *this;
     }
 
     StringArgument& StoreValue(std::string& value) {
-        if (is_multi_value_) {
+        if (Has(kMultiValue)) {
             throw std::runtime_error(
                 "Store value for multi value argument is not supported");
         }
         value_ = &value;
-        is_stored_ = true;
+        Set(kStored);
         return *this;
     }
 
     StringArgument& StoreValues(std::vector<std::string>& values) {
-        if (!is_multi_value_) {
+        if (!Has(kMultiValue)) {
             throw std::runtime_error(
                 "Store value for single value argument is not supported");
         }
         multi_value_ = &values;
-        is_stored_ = true;
+        Set(kStored);
         return *this;
     }
 
-    bool is_default() const { return is_default_; }
-
-   public:
+   private:
     std::string* value_ = nullptr;
     std::vector<std::string>* multi_value_ = nullptr;
-    std::string default_value_;
-    std::vector<std::string> default_multi_value_;
-
-    bool is_default_ = false;
-    int32_t multi_value_count_ = 0;
-    bool is_multi_value_ = false;
-    bool is_set_ = false;
-    bool is_positional_ = false;
-    bool is_stored_ = false;
+    StringPool strings_;
+    StringPool values_;
+    std::vector<std::string_view> views_;
+    std::vector<std::string_view> default_views_;
+    std::vector<std::string_view>* choices_ = nullptr;
+    std::string_view rejected_;
+    size_t lazy_count_ = 0;
+
+    void Reject(std::string_view value) {
+        if (!Has(kInvalid)) {
+            rejected_ = values_.Add(value);
+            Set(kInvalid);
+        }
+    }
 };
 
-// Flag argument
-class FlagArgument : public BaseArgument {
+// File argument
+//
+// A string argument whose values name files ("--key=@secret.pem" or
+// "--key=secret.pem"). Files are opened on first access to their contents
+// and stay mapped for the lifetime of the argument; with Prefetch() the
+// parser loads all of them in parallel at the end of Parse.
+class FileArgument : public StringArgument {
    public:
-    FlagArgument() = default;
-    FlagArgument(char short_name, const std::string& name,
-                 const std::string& description)
-        : BaseArgument(short_name, name, description) {}
-    ~FlagArgument() {
-        if (is_stored_) {
-            return;
+    FileArgument();
+    FileArgument(char short_name, std::string_view name,
+                 std::string_view description);
+    ~FileArgument() override;
+
+    // New values drop the files loaded for the previous ones.
+    void SetValue(std::string_view value) override;
+    void SetValues(std::span<const std::string_view> values,
+                   const ParallelOptions& parallel) override;
+    void Reset() override;
+
+    std::string_view GetPath(int32_t index = 0) const {
+        std::string_view path = GetView(index);
+        if (path.starts_with('@')) {
+            path.remove_prefix(1);
         }
-        delete value_;
+        return path;
     }
 
-    void SetValue(const std::string& value) override {
-        if (value_ == nullptr) {
-            value_ = new bool();
-        }
-        *value_ = !default_value_;
+    // Returns false if the file cannot be read.
+    bool Load(int32_t index = 0) const;
+    std::string_view GetContents(int32_t index = 0) const;
+
+    FileArgument& Prefetch() {
+        Set(kPrefetch);
+        return *this;
     }
 
-    bool IsCorrect() const override { return true; }
+    FileArgument& Positional() {
+        StringArgument::Positional();
+        return *this;
+    }
 
-    std::string GetDefaultValue() const override {
-        return default_value_ ? "true" : "false";
+    FileArgument& Default(const std::string& value) {
+        StringArgument::Default(value);
+        return *this;
+    }
+
+    FileArgument& Default(const std::vector<std::string>& values) {
+        StringArgument::Default(values);
+        return *this;
+    }
+
+    FileArgument& MultiValue(int32_t count = 0) {
+        StringArgument::MultiValue(count);
+        return *this;
     }
 
+    FileArgument& Utf8() {
+        StringArgument::Utf8();
+        return *this;
+    }
+
+   private:
+    struct File;
+    struct Files;
+
+    Files* files_;
+};
+
+// Flag argument
+class FlagArgument : public BaseArgument {
+   public:
+    FlagArgument() = default;
+    FlagArgument(char short_name, std::string_view name,
+                 std::string_view description)
+        : BaseArgument(short_name, name, description) {}
+    ~FlagArgument() override;
+
+    // "--flag" toggles the default, "--flag=true" and "--flag=false" set
+    // the value explicitly.
+    void SetValue(std::string_view value) override;
+    bool IsCorrect() const override { return true; }
+    std::string GetDefaultValue() const override;
+    size_t Footprint() const override;
+
     bool GetValue(int32_t index = 0) const {
         if (value_ == nullptr) {
-            return default_value_;
+            return Has(kDefault);
         }
         return *value_;
     }
 
+    // For flags kDefault holds the default value itself.
     FlagArgument& Default(bool value) {
-        default_value_ = value;
+        if (value) {
+            Set(kDefault);
+        } else {
+            attributes_ &= ~kDefault;
+        }
         return *this;
     }
 
     FlagArgument& StoreValue(bool& value) {
         value_ = &value;
-        is_stored_ = true;
+        Set(kStored);
         return *this;
     }
 
-    bool IsPositional() const override { return false; }
-
     int32_t ValuesCount() const override { return 0; }
 
    private:
     bool* value_ = nullptr;
-    bool default_value_ = false;
-
-    bool is_stored_ = false;
 };
 
-}  // namespace ArgumentParser
\ No newline at end of file
+}  // namespace ArgumentParser
@@ -0,0 +1,151 @@
+#include "Completion.h"
+
+#include <cctype>
+#include <cstdio>
+
+#include "MappedFile.h"
+
+using namespace ArgumentParser;
+
+namespace {
+
+std::string_view LineAt(std::string_view index, size_t start) {
+    size_t end = index.find('\n', start);
+    if (end == std::string_view::npos) {
+        end = index.size();
+    }
+    return index.substr(start, end - start);
+}
+
+size_t LineStart(std::string_view index, size_t position) {
+    if (position == 0) {
+        return 0;
+    }
+    size_t newline = index.rfind('\n', position - 1);
+    return newline == std::string_view::npos ? 0 : newline + 1;
+}
+
+std::string FunctionName(std::string_view program) {
+    std::string name = "_";
+    for (char c : program) {
+        name += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+    }
+    return name + "_complete";
+}
+
+// value as one single-quoted word. Bash and zsh have no escapes inside
+// single quotes, so a quote there ends the word, is escaped and reopens it.
+std::string Quote(Shell shell, std::string_view value) {
+    std::string quoted = "'";
+    for (char c : value) {
+        if (c == '\'' && shell == Shell::kFish) {
+            quoted += "\\'";
+        } else if (c == '\'') {
+            quoted += "'\\''";
+        } else if (c == '\\' && shell == Shell::kFish) {
+            quoted += "\\\\";
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "'";
+}
+
+}  // namespace
+
+bool ArgumentParser::IsCompletionQuery(int32_t argc, char** argv) {
+    return argc >= 3 && argv[1] == kCompleteOption;
+}
+
+bool ArgumentParser::IsCompletionIndexRequest(int32_t argc, char** argv) {
+    return argc == 3 && argv[1] == kCompletionIndexOption;
+}
+
+int32_t ArgumentParser::AnswerCompletion(int32_t argc, char** argv) {
+    MappedFile index;
+    if (!index.Open(argv[2])) {
+        return 1;
+    }
+    std::string_view prefix = argc >= 4 ? argv[argc - 1] : "";
+    std::string out;
+    Complete(index.contents(), prefix, out);
+    std::fwrite(out.data(), 1, out.size(), stdout);
+    return 0;
+}
+
+void ArgumentParser::Complete(std::string_view index, std::string_view prefix,
+                              std::string& out) {
+    size_t low = 0;
+    size_t high = index.size();
+    while (low < high) {
+        size_t start = LineStart(index, low + (high - low) / 2);
+        std::string_view line = LineAt(index, start);
+        if (line < prefix) {
+            low = start + line.size() + 1;
+        } else {
+            high = start;
+        }
+    }
+    while (low < index.size()) {
+        std::string_view line = LineAt(index, low);
+        if (!line.starts_with(prefix)) {
+            break;
+        }
+        out += line;
+        out += '\n';
+        low += line.size() + 1;
+    }
+}
+
+std::string ArgumentParser::CompletionScript(Shell shell,
+                                             std::string_view program,
+                                             std::string_view index_path,
+                                             bool has_positional) {
+    std::string name(program);
+    std::string function = FunctionName(program);
+    std::string query = name + " --__complete " + Quote(shell, index_path);
+    switch (shell) {
+        case Shell::kBash:
+            return function + "() {\n"
+                   "    local line=${COMP_LINE:0:COMP_POINT}\n"
+                   "    local cur=${line##*[[:space:]]}\n"
+                   "    if [[ \"$cur\" != -* ]]; then\n" +
+                   (has_positional
+                        ? "        COMPREPLY=($(compgen -f -- \"$cur\"))\n"
+                        : "        COMPREPLY=()\n") +
+                   "        return\n"
+                   "    fi\n"
+                   "    local IFS=$'\\n'\n"
+                   "    COMPREPLY=($(" + query +
+                   " \"$cur\" | cut -f1))\n"
+                   "    if [[ \"$cur\" == *=* ]]; then\n"
+                   "        COMPREPLY=(\"${COMPREPLY[@]#*=}\")\n"
+                   "    fi\n"
+                   "}\n"
+                   "complete -F " + function + " " + name + "\n";
+        case Shell::kZsh:
+            return "#compdef " + name + "\n" + function + "() {\n"
+                   "    if [[ $PREFIX == -* ]]; then\n"
+                   "        local -a candidates\n"
+                   "        candidates=(\"${(@f)$(" + query +
+                   " \"$PREFIX\")}\")\n"
+                   "        candidates=(\"${(@)candidates//:/\\\\:}\")\n"
+                   "        candidates=(\"${(@)candidates//$'\\t'/:}\")\n"
+                   "        _describe -t options option candidates\n" +
+                   (has_positional ? "    else\n"
+                                     "        _files\n"
+                                   : "") +
+                   "    fi\n"
+                   "}\n"
+                   "compdef " + function + " " + name + "\n";
+        case Shell::kFish:
+            break;
+    }
+    return "function " + function + "\n"
+           "    set -l token (commandline -ct)\n"
+           "    string match -q -- '-*' $token; and " + query +
+           " $token\n"
+           "end\n"
+           "complete -c " + name + (has_positional ? "" : " -f") +
+           " -a '(" + function + ")'\n";
+}
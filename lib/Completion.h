@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cinttypes>
+#include <string>
+#include <string_view>
+
+namespace ArgumentParser {
+
+enum class Shell { kBash, kZsh, kFish };
+
+// Completion queries look like "program --__complete <index> <word>", where
+// index is a file written by ArgParser::WriteCompletionIndex (typically at
+// build time with "program --__completion-index <index>"). They are
+// answered from that file alone, so a program handles them before it
+// builds its ArgParser:
+//
+//     if (IsCompletionQuery(argc, argv)) {
+//         return AnswerCompletion(argc, argv);
+//     }
+//
+// Answering takes well under a millisecond, less than loading a shared C++
+// runtime, so such programs are best linked with -static-libstdc++.
+inline constexpr std::string_view kCompleteOption = "--__complete";
+inline constexpr std::string_view kCompletionIndexOption =
+    "--__completion-index";
+
+bool IsCompletionQuery(int32_t argc, char** argv);
+bool IsCompletionIndexRequest(int32_t argc, char** argv);
+
+// Writes the index entries matching the word after the index path to
+// stdout, one "candidate<TAB>description" per line. Returns the process
+// exit code, 1 if the index cannot be read.
+int32_t AnswerCompletion(int32_t argc, char** argv);
+
+// Appends the index entries whose candidate starts with prefix to out. The
+// index is a sorted list of lines, so this is a binary search plus a scan
+// over the matches.
+void Complete(std::string_view index, std::string_view prefix,
+              std::string& out);
+
+// Script that completes program by querying it with --__complete and the
+// given index file. Words not starting with '-' complete as files when
+// has_positional is set.
+std::string CompletionScript(Shell shell, std::string_view program,
+                             std::string_view index_path, bool has_positional);
+
+}  // namespace ArgumentParser
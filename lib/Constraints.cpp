@@ -0,0 +1,94 @@
+#include "Constraints.h"
+
+#include <algorithm>
+#include <bit>
+
+using namespace ArgumentParser;
+
+namespace {
+
+using Mask = std::vector<std::pair<uint32_t, uint64_t>>;
+
+Mask MakeMask(std::span<const uint32_t> arguments) {
+    Mask mask;
+    for (uint32_t argument : arguments) {
+        uint32_t word = argument / 64;
+        auto it = std::lower_bound(
+            mask.begin(), mask.end(), word,
+            [](const auto& entry, uint32_t key) { return entry.first < key; });
+        if (it == mask.end() || it->first != word) {
+            it = mask.insert(it, {word, 0});
+        }
+        it->second |= uint64_t(1) << (argument % 64);
+    }
+    return mask;
+}
+
+int32_t CountSeen(std::span<const uint64_t> seen, const Mask& mask) {
+    int32_t count = 0;
+    for (auto& [word, bits] : mask) {
+        count += std::popcount(seen[word] & bits);
+    }
+    return count;
+}
+
+int32_t CountAll(const Mask& mask) {
+    int32_t count = 0;
+    for (auto& [word, bits] : mask) {
+        count += std::popcount(bits);
+    }
+    return count;
+}
+
+}  // namespace
+
+void ConstraintSet::Add(Kind kind, const std::vector<uint32_t>& arguments) {
+    Rule rule{kind, arguments, {}, {}, 0, 0};
+    if (kind == Kind::kRequires) {
+        rule.mask = MakeMask(std::span(arguments).first(1));
+        rule.required = MakeMask(std::span(arguments).subspan(1));
+    } else {
+        rule.mask = MakeMask(arguments);
+    }
+    rule.mask_count = CountAll(rule.mask);
+    rule.required_count = CountAll(rule.required);
+    rules_.push_back(std::move(rule));
+}
+
+void ConstraintSet::Check(std::span<const uint64_t> seen,
+                          std::vector<size_t>& violations) const {
+    for (size_t i = 0; i < rules_.size(); ++i) {
+        const Rule& rule = rules_[i];
+        int32_t count = CountSeen(seen, rule.mask);
+        bool is_violated = false;
+        switch (rule.kind) {
+            case Kind::kMutuallyExclusive:
+                is_violated = count > 1;
+                break;
+            case Kind::kRequiredTogether:
+                is_violated = count != 0 && count != rule.mask_count;
+                break;
+            case Kind::kAtLeastOne:
+                is_violated = count == 0;
+                break;
+            case Kind::kRequires:
+                is_violated =
+                    count != 0 &&
+                    CountSeen(seen, rule.required) != rule.required_count;
+                break;
+        }
+        if (is_violated) {
+            violations.push_back(i);
+        }
+    }
+}
+
+size_t ConstraintSet::Footprint() const {
+    size_t size = sizeof(ConstraintSet) + rules_.capacity() * sizeof(Rule);
+    for (const Rule& rule : rules_) {
+        size += rule.arguments.capacity() * sizeof(uint32_t) +
+                (rule.mask.capacity() + rule.required.capacity()) *
+                    sizeof(rule.mask[0]);
+    }
+    return size;
+}
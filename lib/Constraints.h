@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cinttypes>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace ArgumentParser {
+
+// Rules between arguments, evaluated against the bitset of arguments seen
+// during a parse. Every rule keeps a sparse mask of (word, bits) pairs, so a
+// check costs one AND and popcount per 64 arguments it mentions.
+class ConstraintSet {
+   public:
+    enum class Kind {
+        kMutuallyExclusive,  // at most one of the arguments
+        kRequiredTogether,   // all of the arguments or none
+        kAtLeastOne,         // one or more of the arguments
+        kRequires,           // arguments[0] requires all of the others
+    };
+
+    struct Rule {
+        Kind kind;
+        std::vector<uint32_t> arguments;
+        std::vector<std::pair<uint32_t, uint64_t>> mask;
+        std::vector<std::pair<uint32_t, uint64_t>> required;
+        int32_t mask_count;
+        int32_t required_count;
+    };
+
+    void Add(Kind kind, const std::vector<uint32_t>& arguments);
+
+    // Appends the indices of the violated rules to violations.
+    void Check(std::span<const uint64_t> seen,
+               std::vector<size_t>& violations) const;
+
+    const std::vector<Rule>& rules() const { return rules_; }
+    // Bytes used by the rules and their masks.
+    size_t Footprint() const;
+
+   private:
+    std::vector<Rule> rules_;
+};
+
+}  // namespace ArgumentParser
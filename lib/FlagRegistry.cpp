@@ -0,0 +1,241 @@
+#include "FlagRegistry.h"
+
+#include <cstdio>
+#include <stdexcept>
+#include <type_traits>
+
+#include "ArgParser.h"
+#include "Tokenizer.h"
+
+using namespace ArgumentParser;
+
+namespace {
+
+bool ReadFile(const std::string& path, std::string& content) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    char buffer[4096];
+    size_t size;
+    while ((size = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        content.append(buffer, size);
+    }
+    bool is_ok = std::ferror(file) == 0;
+    std::fclose(file);
+    return is_ok;
+}
+
+void StripComments(std::string& content) {
+    size_t line = 0;
+    while (line < content.size()) {
+        size_t end = content.find('\n', line);
+        if (end == std::string::npos) {
+            end = content.size();
+        }
+        size_t first = content.find_first_not_of(" \t", line);
+        if (first < end && content[first] == '#') {
+            content.replace(line, end - line, end - line, ' ');
+        }
+        line = end + 1;
+    }
+}
+
+// Where a reading thread announces the string flag copy it reads. Slots are
+// aligned so that readers never write to a shared cache line, and never
+// freed: a thread that exits hands its slot to the next one.
+struct alignas(64) HazardSlot {
+    std::atomic<const void*> pointer = nullptr;
+    std::atomic<bool> is_taken = false;
+    HazardSlot* next = nullptr;
+};
+
+std::atomic<HazardSlot*> hazard_slots = nullptr;
+
+HazardSlot* AcquireSlot() {
+    for (HazardSlot* slot = hazard_slots.load(); slot != nullptr;
+         slot = slot->next) {
+        bool is_taken = false;
+        if (slot->is_taken.compare_exchange_strong(is_taken, true)) {
+            return slot;
+        }
+    }
+    HazardSlot* slot = new HazardSlot();
+    slot->is_taken = true;
+    slot->next = hazard_slots.load();
+    while (!hazard_slots.compare_exchange_weak(slot->next, slot)) {
+    }
+    return slot;
+}
+
+struct SlotOwner {
+    HazardSlot* slot = AcquireSlot();
+    ~SlotOwner() {
+        slot->pointer.store(nullptr);
+        slot->is_taken.store(false);
+    }
+};
+
+HazardSlot& LocalSlot() {
+    thread_local SlotOwner owner;
+    return *owner.slot;
+}
+
+bool IsAnnounced(const void* pointer) {
+    for (HazardSlot* slot = hazard_slots.load(); slot != nullptr;
+         slot = slot->next) {
+        if (slot->pointer.load() == pointer) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+template <typename T>
+void Flag<T>::AddTo(ArgParser& parser) const {
+    if constexpr (std::is_same_v<T, bool>) {
+        parser.AddFlag(name(), description()).Default(default_);
+    } else {
+        parser.AddIntArgument(name(), description()).Default(default_);
+    }
+}
+
+template <typename T>
+void Flag<T>::Publish(const ArgParser& parser) {
+    using Argument =
+        std::conditional_t<std::is_same_v<T, bool>, FlagArgument, IntArgument>;
+    // A same-named argument of another type is not this flag's.
+    auto* argument = dynamic_cast<Argument*>(parser.GetArgument(name()));
+    if (argument == nullptr || !argument->is_set()) {
+        return;
+    }
+    value_.store(argument->GetValue(), std::memory_order_release);
+}
+
+template class ArgumentParser::Flag<int32_t>;
+template class ArgumentParser::Flag<bool>;
+
+void Flag<std::string>::AddTo(ArgParser& parser) const {
+    parser.AddStringArgument(name(), description()).Default(Get());
+}
+
+Flag<std::string>::~Flag() {
+    delete value_.load();
+    for (const std::string* copy : retired_) {
+        delete copy;
+    }
+}
+
+std::string Flag<std::string>::Get() const {
+    std::string value;
+    Get(value);
+    return value;
+}
+
+void Flag<std::string>::Get(std::string& value) const {
+    HazardSlot& slot = LocalSlot();
+    const std::string* current = value_.load(std::memory_order_acquire);
+    while (true) {
+        slot.pointer.store(current);
+        // Publish either sees the announcement or has already replaced the
+        // copy, which this load then notices.
+        const std::string* again = value_.load();
+        if (again == current) {
+            break;
+        }
+        current = again;
+    }
+    value.assign(*current);
+    slot.pointer.store(nullptr, std::memory_order_release);
+}
+
+void Flag<std::string>::Publish(const ArgParser& parser) {
+    auto* argument = dynamic_cast<StringArgument*>(parser.GetArgument(name()));
+    if (argument == nullptr || !argument->is_set()) {
+        return;
+    }
+    std::string_view value = argument->GetView();
+    const std::string* current = value_.load();
+    if (*current == value) {
+        return;
+    }
+    value_.store(new std::string(value));
+    retired_.push_back(current);
+    std::erase_if(retired_, [](const std::string* copy) {
+        if (IsAnnounced(copy)) {
+            return false;
+        }
+        delete copy;
+        return true;
+    });
+}
+
+FlagRegistry& FlagRegistry::Global() {
+    static FlagRegistry registry;
+    return registry;
+}
+
+template <typename T>
+Flag<T>& FlagRegistry::Define(const std::string& name,
+                              const std::string& description, const T& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Flag<T>* flag = new Flag<T>(name, description, value);
+    flags_.emplace_back(flag);
+    return *flag;
+}
+
+Flag<int32_t>& FlagRegistry::DefineInt(const std::string& name, int32_t value,
+                                       const std::string& description) {
+    return Define<int32_t>(name, description, value);
+}
+
+Flag<bool>& FlagRegistry::DefineFlag(const std::string& name, bool value,
+                                     const std::string& description) {
+    return Define<bool>(name, description, value);
+}
+
+Flag<std::string>& FlagRegistry::DefineString(const std::string& name,
+                                              const std::string& value,
+                                              const std::string& description) {
+    return Define<std::string>(name, description, value);
+}
+
+void FlagRegistry::Register(ArgParser& parser) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& flag : flags_) {
+        flag->AddTo(parser);
+    }
+}
+
+void FlagRegistry::Publish(const ArgParser& parser) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& flag : flags_) {
+        flag->Publish(parser);
+    }
+}
+
+bool FlagRegistry::Reload(const std::string& path) {
+    std::string content;
+    if (!ReadFile(path, content)) {
+        return false;
+    }
+    StripComments(content);
+    Tokenizer tokenizer;
+    if (!tokenizer.Tokenize(content)) {
+        return false;
+    }
+
+    ArgParser parser(path);
+    Register(parser);
+    try {
+        if (!parser.Parse(tokenizer.args(), 0)) {
+            return false;
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    Publish(parser);
+    return true;
+}
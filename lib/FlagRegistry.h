@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ArgumentParser {
+
+class ArgParser;
+
+class FlagBase {
+   public:
+    FlagBase(const std::string& name, const std::string& description)
+        : name_(name), description_(description) {}
+    virtual ~FlagBase() = default;
+
+    const std::string& name() const { return name_; }
+    const std::string& description() const { return description_; }
+
+    virtual void AddTo(ArgParser& parser) const = 0;
+    virtual void Publish(const ArgParser& parser) = 0;
+
+   private:
+    std::string name_;
+    std::string description_;
+};
+
+// A process-wide flag. Get() is a single acquire load and never blocks,
+// even while the registry publishes new values.
+template <typename T>
+class Flag : public FlagBase {
+   public:
+    Flag(const std::string& name, const std::string& description,
+         const T& value)
+        : FlagBase(name, description), value_(value), default_(value) {}
+
+    T Get() const { return value_.load(std::memory_order_acquire); }
+
+    // Adds the flag with its declared default, not the current value: a bare
+    // "--flag" toggles against the default, so reloading the same file must
+    // always give the same value.
+    void AddTo(ArgParser& parser) const override;
+    void Publish(const ArgParser& parser) override;
+
+   private:
+    std::atomic<T> value_;
+    const T default_;
+};
+
+// String flags publish immutable copies through an atomic pointer. A reader
+// announces the copy it is about to read in a hazard slot owned by its
+// thread and reads it once the flag still points there, so Get() is a load,
+// a store no other thread makes and a validating load; it never blocks.
+// Publish swaps in a new copy and never waits either: replaced copies that a
+// slot still announces are freed by a later Publish, so at most one per
+// reading thread is kept.
+template <>
+class Flag<std::string> : public FlagBase {
+   public:
+    Flag(const std::string& name, const std::string& description,
+         const std::string& value)
+        : FlagBase(name, description), value_(new std::string(value)) {}
+    ~Flag() override;
+
+    std::string Get() const;
+    // Copies the value into value, reusing its buffer.
+    void Get(std::string& value) const;
+
+    void AddTo(ArgParser& parser) const override;
+    // Calls are serialized by the registry.
+    void Publish(const ArgParser& parser) override;
+
+   private:
+    std::atomic<const std::string*> value_;
+    // Replaced copies a reader may still be reading.
+    std::vector<const std::string*> retired_;
+};
+
+// Collects flags defined across translation units (see ARGPARSER_DEFINE_*).
+// Register adds them to an ArgParser at startup, Publish stores the parsed
+// values, and Reload re-reads them from a file while readers keep running.
+class FlagRegistry {
+   public:
+    static FlagRegistry& Global();
+
+    Flag<int32_t>& DefineInt(const std::string& name, int32_t value,
+                             const std::string& description = "");
+    Flag<bool>& DefineFlag(const std::string& name, bool value,
+                           const std::string& description = "");
+    Flag<std::string>& DefineString(const std::string& name,
+                                    const std::string& value,
+                                    const std::string& description = "");
+
+    void Register(ArgParser& parser) const;
+    void Publish(const ArgParser& parser);
+
+    // Reads whitespace separated "--name=value" arguments (shell quoting,
+    // lines starting with '#' are comments). Flags missing from the file
+    // keep their values. Nothing is published if the file cannot be read or
+    // does not parse.
+    bool Reload(const std::string& path);
+
+   private:
+    template <typename T>
+    Flag<T>& Define(const std::string& name, const std::string& description,
+                    const T& value);
+
+    mutable std::mutex mutex_;
+    std::deque<std::unique_ptr<FlagBase>> flags_;
+};
+
+}  // namespace ArgumentParser
+
+#define ARGPARSER_DEFINE_INT(name, value, description)         \
+    ::ArgumentParser::Flag<int32_t>& FLAGS_##name =             \
+        ::ArgumentParser::FlagRegistry::Global().DefineInt(     \
+            #name, value, description)
+#define ARGPARSER_DEFINE_FLAG(name, value, description)        \
+    ::ArgumentParser::Flag<bool>& FLAGS_##name =                \
+        ::ArgumentParser::FlagRegistry::Global().DefineFlag(    \
+            #name, value, description)
+#define ARGPARSER_DEFINE_STRING(name, value, description)      \
+    ::ArgumentParser::Flag<std::string>& FLAGS_##name =         \
+        ::ArgumentParser::FlagRegistry::Global().DefineString(  \
+            #name, value, description)
+#define ARGPARSER_DECLARE_INT(name) \
+    extern ::ArgumentParser::Flag<int32_t>& FLAGS_##name
+#define ARGPARSER_DECLARE_FLAG(name) \
+    extern ::ArgumentParser::Flag<bool>& FLAGS_##name
+#define ARGPARSER_DECLARE_STRING(name) \
+    extern ::ArgumentParser::Flag<std::string>& FLAGS_##name
@@ -0,0 +1,86 @@
+#include "MappedFile.h"
+
+#include <cstdio>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ARGPARSER_HAS_MMAP 1
+#endif
+
+using namespace ArgumentParser;
+
+MappedFile::~MappedFile() {
+#if defined(ARGPARSER_HAS_MMAP)
+    if (is_mapped_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
+
+bool MappedFile::Open(const std::string& path,
+                      [[maybe_unused]] bool populate) {
+#if defined(ARGPARSER_HAS_MMAP)
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) != 0 || !S_ISREG(status.st_mode)) {
+        close(descriptor);
+        return false;
+    }
+    size_ = status.st_size;
+    if (size_ != 0) {
+        int flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+        if (populate) {
+            flags |= MAP_POPULATE;
+        }
+#endif
+        void* data = mmap(nullptr, size_, PROT_READ, flags, descriptor, 0);
+        if (data == MAP_FAILED) {
+            close(descriptor);
+            size_ = 0;
+            return false;
+        }
+        data_ = static_cast<const char*>(data);
+        is_mapped_ = true;
+#if !defined(MAP_POPULATE)
+        if (populate) {
+            madvise(data, size_, MADV_WILLNEED);
+            size_t page = sysconf(_SC_PAGESIZE);
+            volatile char sink = 0;
+            for (size_t offset = 0; offset < size_; offset += page) {
+                sink = sink + data_[offset];
+            }
+        }
+#endif
+    }
+    close(descriptor);
+    return true;
+#else
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    std::string content;
+    char chunk[4096];
+    size_t size;
+    while ((size = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        content.append(chunk, size);
+    }
+    bool is_ok = std::ferror(file) == 0;
+    std::fclose(file);
+    if (!is_ok) {
+        return false;
+    }
+    buffer_.reset(new char[content.size()]);
+    content.copy(buffer_.get(), content.size());
+    data_ = buffer_.get();
+    size_ = content.size();
+    return true;
+#endif
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace ArgumentParser {
+
+// Read-only file contents, memory mapped where the platform supports it and
+// read into a buffer otherwise.
+class MappedFile {
+   public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    // With populate the pages are read in before Open returns, so the cost
+    // of I/O is paid by the caller (the prefetch task) and not on first
+    // access to contents().
+    bool Open(const std::string& path, bool populate = false);
+
+    std::string_view contents() const { return std::string_view(data_, size_); }
+
+   private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool is_mapped_ = false;
+    std::unique_ptr<char[]> buffer_;
+};
+
+}  // namespace ArgumentParser
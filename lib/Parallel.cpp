@@ -0,0 +1,188 @@
+#include "Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace ArgumentParser;
+
+namespace {
+
+struct alignas(64) WorkRange {
+    // Low 32 bits hold the end of the slice, high 32 bits its begin.
+    std::atomic<uint64_t> bounds{0};
+};
+
+uint64_t Pack(uint64_t begin, uint64_t end) { return (begin << 32) | end; }
+uint64_t Begin(uint64_t bounds) { return bounds >> 32; }
+uint64_t End(uint64_t bounds) { return bounds & UINT32_MAX; }
+
+bool PopFront(WorkRange& range, size_t& task) {
+    uint64_t bounds = range.bounds.load(std::memory_order_acquire);
+    while (Begin(bounds) < End(bounds)) {
+        if (range.bounds.compare_exchange_weak(
+                bounds, Pack(Begin(bounds) + 1, End(bounds)),
+                std::memory_order_acq_rel)) {
+            task = Begin(bounds);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool StealHalf(WorkRange& victim, WorkRange& thief) {
+    uint64_t bounds = victim.bounds.load(std::memory_order_acquire);
+    while (Begin(bounds) < End(bounds)) {
+        uint64_t middle = Begin(bounds) + (End(bounds) - Begin(bounds)) / 2;
+        if (victim.bounds.compare_exchange_weak(
+                bounds, Pack(Begin(bounds), middle),
+                std::memory_order_acq_rel)) {
+            thief.bounds.store(Pack(middle, End(bounds)),
+                               std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Process-wide threads reused by every ParallelFor. A job asks for a number
+// of helper slots; idle threads claim them in order, and the caller takes
+// back the slots nobody claimed once its own share is done, so it never
+// waits for a thread that has not started.
+class WorkerPool {
+   public:
+    static WorkerPool& Global() {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            is_stopped_ = true;
+        }
+        work_available_.notify_all();
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    // Runs work(slot) for slot 0 on the calling thread and for slots
+    // [1, slots) on pool threads that are free to take them.
+    void Run(size_t slots, const std::function<void(size_t)>& work) {
+        Job job{&work, 1, slots, 0};
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            while (threads_.size() < slots - 1) {
+                threads_.emplace_back([this] { Work(); });
+            }
+            jobs_.push_back(&job);
+        }
+        work_available_.notify_all();
+
+        work(0);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (job.next_slot < job.slots) {
+            jobs_.erase(std::find(jobs_.begin(), jobs_.end(), &job));
+            job.slots = job.next_slot;
+        }
+        job_done_.wait(lock, [&job] { return job.done == job.slots - 1; });
+    }
+
+   private:
+    struct Job {
+        const std::function<void(size_t)>* work;
+        size_t next_slot;
+        size_t slots;
+        size_t done;
+    };
+
+    void Work() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            work_available_.wait(
+                lock, [this] { return is_stopped_ || !jobs_.empty(); });
+            if (is_stopped_) {
+                return;
+            }
+            Job* job = jobs_.front();
+            size_t slot = job->next_slot++;
+            if (job->next_slot == job->slots) {
+                jobs_.pop_front();
+            }
+            lock.unlock();
+            (*job->work)(slot);
+            lock.lock();
+            if (++job->done == job->slots - 1) {
+                job_done_.notify_all();
+            }
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable job_done_;
+    std::deque<Job*> jobs_;
+    std::vector<std::thread> threads_;
+    bool is_stopped_ = false;
+};
+
+}  // namespace
+
+void ArgumentParser::ParallelFor(size_t count, size_t threads,
+                                 const std::function<void(size_t)>& body) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min(threads, count);
+    if (threads <= 1 || count > UINT32_MAX) {
+        for (size_t task = 0; task < count; ++task) {
+            body(task);
+        }
+        return;
+    }
+
+    std::unique_ptr<WorkRange[]> ranges(new WorkRange[threads]);
+    for (size_t i = 0; i < threads; ++i) {
+        ranges[i].bounds = Pack(count * i / threads, count * (i + 1) / threads);
+    }
+
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto worker = [&](size_t self) {
+        try {
+            size_t task;
+            while (true) {
+                while (PopFront(ranges[self], task)) {
+                    body(task);
+                }
+                bool is_stolen = false;
+                for (size_t k = 1; k < threads && !is_stolen; ++k) {
+                    is_stolen =
+                        StealHalf(ranges[(self + k) % threads], ranges[self]);
+                }
+                if (!is_stolen) {
+                    return;
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (error == nullptr) {
+                error = std::current_exception();
+            }
+        }
+    };
+
+    WorkerPool::Global().Run(threads, worker);
+    if (error != nullptr) {
+        std::rethrow_exception(error);
+    }
+}
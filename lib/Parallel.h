@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace ArgumentParser {
+
+// Runs body(task) for every task in [0, count) on a work-stealing pool.
+// The pool threads are started on first use and reused by later calls; the
+// calling thread works too. Each worker starts with a contiguous slice of
+// the tasks and, once it is drained, steals the back half of another
+// worker's slice. The first exception thrown by body is rethrown on the
+// calling thread.
+void ParallelFor(size_t count, size_t threads,
+                 const std::function<void(size_t)>& body);
+
+}  // namespace ArgumentParser
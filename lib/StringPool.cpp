@@ -0,0 +1,48 @@
+#include "StringPool.hpp"
+
+#include <algorithm>
+
+using namespace ArgumentParser;
+
+StringPool::~StringPool() {
+    for (char* block : blocks_) {
+        delete[] block;
+    }
+}
+
+void StringPool::Grow(size_t size) {
+    size_t block_size = std::max(
+        size, kMinBlockSize << std::min<size_t>(blocks_.size(), 10));
+    blocks_.push_back(new char[block_size]);
+    capacity_ += block_size;
+    current_ = blocks_.back();
+    left_ = block_size;
+    block_size_ = block_size;
+}
+
+void StringPool::Reset() {
+    if (blocks_.empty()) {
+        return;
+    }
+    if (blocks_.size() > 1) {
+        std::swap(blocks_.front(), blocks_.back());
+        for (size_t i = 1; i < blocks_.size(); ++i) {
+            delete[] blocks_[i];
+        }
+        blocks_.resize(1);
+        capacity_ = block_size_;
+    }
+    current_ = blocks_.front();
+    left_ = block_size_;
+}
+
+void StringInterner::Rehash() {
+    std::vector<std::string_view> slots(
+        std::max(kMinSlots, 2 * slots_.size()));
+    slots.swap(slots_);
+    for (std::string_view value : slots) {
+        if (value.data() != nullptr) {
+            Find(value) = value;
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace ArgumentParser {
+
+// Append-only arena for names, descriptions and values. Blocks never move,
+// so every returned view stays valid until Reset or the end of the pool.
+class StringPool {
+   public:
+    StringPool() = default;
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+    ~StringPool();
+
+    std::string_view Add(std::string_view value) {
+        if (value.empty()) {
+            return {};
+        }
+        char* data = Allocate(value.size());
+        std::memcpy(data, value.data(), value.size());
+        return std::string_view(data, value.size());
+    }
+
+    char* Allocate(size_t size) {
+        if (size > left_) {
+            Grow(size);
+        }
+        char* data = current_;
+        current_ += size;
+        left_ -= size;
+        return data;
+    }
+
+    // Drops every string but keeps the newest block, so a pool refilled with
+    // about as much data as before does not allocate.
+    void Reset();
+
+    size_t capacity() const {
+        return capacity_ + blocks_.capacity() * sizeof(blocks_[0]);
+    }
+
+   private:
+    static constexpr size_t kMinBlockSize = 64;
+
+    // Starts a block with room for at least size bytes.
+    void Grow(size_t size);
+
+    std::vector<char*> blocks_;
+    char* current_ = nullptr;
+    size_t left_ = 0;
+    size_t block_size_ = 0;
+    size_t capacity_ = 0;
+};
+
+// Open-addressing set of strings stored in a StringPool, so repeated values
+// (typically descriptions) are kept once.
+class StringInterner {
+   public:
+    std::string_view Intern(StringPool& pool, std::string_view value) {
+        if (value.empty()) {
+            return {};
+        }
+        if (2 * (count_ + 1) > slots_.size()) {
+            Rehash();
+        }
+        std::string_view& slot = Find(value);
+        if (slot.data() == nullptr) {
+            slot = pool.Add(value);
+            ++count_;
+        }
+        return slot;
+    }
+
+    size_t capacity() const {
+        return slots_.capacity() * sizeof(std::string_view);
+    }
+
+   private:
+    static constexpr size_t kMinSlots = 16;
+
+    std::string_view& Find(std::string_view value) {
+        size_t mask = slots_.size() - 1;
+        size_t i = std::hash<std::string_view>{}(value) & mask;
+        while (slots_[i].data() != nullptr && slots_[i] != value) {
+            i = (i + 1) & mask;
+        }
+        return slots_[i];
+    }
+
+    // Doubles the slots, starting from kMinSlots.
+    void Rehash();
+
+    std::vector<std::string_view> slots_;
+    size_t count_ = 0;
+};
+
+}  // namespace ArgumentParser
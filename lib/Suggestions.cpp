@@ -0,0 +1,174 @@
+#include "Suggestions.h"
+
+#include <algorithm>
+#include <array>
+
+using namespace ArgumentParser;
+
+namespace {
+
+// Names sharing the most trigrams with the query that are compared by edit
+// distance.
+constexpr size_t kMaxCandidates = 64;
+
+template <typename Callback>
+void ForEachTrigram(std::string_view name, Callback callback) {
+    // The name is padded with one marker on each side, so that the first and
+    // last characters get their own trigrams and short names are indexed.
+    auto at = [&name](size_t i) -> uint32_t {
+        if (i == 0 || i == name.size() + 1) {
+            return 0;
+        }
+        return static_cast<unsigned char>(name[i - 1]);
+    };
+    for (size_t i = 0; i + 2 < name.size() + 2; ++i) {
+        callback((at(i) << 16) | (at(i + 1) << 8) | at(i + 2));
+    }
+}
+
+int32_t MyersDistance(std::string_view pattern, std::string_view text) {
+    std::array<uint64_t, 256> peq{};
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        peq[static_cast<unsigned char>(pattern[i])] |= uint64_t(1) << i;
+    }
+    uint64_t last = uint64_t(1) << (pattern.size() - 1);
+    uint64_t pv = ~uint64_t(0);
+    uint64_t mv = 0;
+    int32_t score = pattern.size();
+    for (char c : text) {
+        uint64_t eq = peq[static_cast<unsigned char>(c)];
+        uint64_t xv = eq | mv;
+        uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+        if (ph & last) {
+            ++score;
+        } else if (mh & last) {
+            --score;
+        }
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+    return score;
+}
+
+int32_t DynamicDistance(std::string_view pattern, std::string_view text) {
+    std::vector<int32_t> row(pattern.size() + 1);
+    for (size_t i = 0; i < row.size(); ++i) {
+        row[i] = i;
+    }
+    for (size_t j = 1; j <= text.size(); ++j) {
+        int32_t diagonal = row[0];
+        row[0] = j;
+        for (size_t i = 1; i <= pattern.size(); ++i) {
+            int32_t current = row[i];
+            row[i] = std::min({row[i] + 1, row[i - 1] + 1,
+                               diagonal + (pattern[i - 1] != text[j - 1])});
+            diagonal = current;
+        }
+    }
+    return row.back();
+}
+
+}  // namespace
+
+int32_t ArgumentParser::EditDistance(std::string_view pattern,
+                                     std::string_view text) {
+    if (pattern.empty()) {
+        return text.size();
+    }
+    if (pattern.size() <= 64) {
+        return MyersDistance(pattern, text);
+    }
+    return DynamicDistance(pattern, text);
+}
+
+void SuggestionIndex::Build(std::span<const std::string_view> names) {
+    names_.assign(names.begin(), names.end());
+    postings_.clear();
+    for (uint32_t i = 0; i < names_.size(); ++i) {
+        ForEachTrigram(names_[i], [this, i](uint32_t trigram) {
+            postings_.emplace_back(trigram, i);
+        });
+    }
+    std::sort(postings_.begin(), postings_.end());
+    postings_.erase(std::unique(postings_.begin(), postings_.end()),
+                    postings_.end());
+}
+
+std::vector<uint32_t> SuggestionIndex::Suggest(std::string_view query,
+                                               size_t count) const {
+    using Posting = std::pair<uint32_t, uint32_t>;
+    std::vector<std::pair<const Posting*, const Posting*>> lists;
+    ForEachTrigram(query, [this, &lists](uint32_t trigram) {
+        auto [begin, end] = std::equal_range(
+            postings_.begin(), postings_.end(), Posting(trigram, 0),
+            [](const Posting& lhs, const Posting& rhs) {
+                return lhs.first < rhs.first;
+            });
+        if (begin != end) {
+            lists.emplace_back(&*begin, &*begin + (end - begin));
+        }
+    });
+
+    // Trigrams shared by a large part of the schema ("ena", "-en") say
+    // little about which name was meant; skip them unless nothing else
+    // matched.
+    size_t common_size = std::max(kMaxCandidates, names_.size() / 16);
+    bool has_rare = std::any_of(lists.begin(), lists.end(), [&](auto list) {
+        return static_cast<size_t>(list.second - list.first) <= common_size;
+    });
+    std::vector<uint32_t> hits;
+    for (auto [begin, end] : lists) {
+        if (has_rare && static_cast<size_t>(end - begin) > common_size) {
+            continue;
+        }
+        for (const Posting* posting = begin; posting != end; ++posting) {
+            hits.push_back(posting->second);
+        }
+    }
+    std::sort(hits.begin(), hits.end());
+
+    // (shared trigrams, name index)
+    std::vector<std::pair<uint32_t, uint32_t>> candidates;
+    for (size_t i = 0; i < hits.size();) {
+        size_t j = i;
+        while (j < hits.size() && hits[j] == hits[i]) {
+            ++j;
+        }
+        candidates.emplace_back(j - i, hits[i]);
+        i = j;
+    }
+    if (candidates.size() > kMaxCandidates) {
+        std::nth_element(candidates.begin(),
+                         candidates.begin() + kMaxCandidates, candidates.end(),
+                         std::greater<>());
+        candidates.resize(kMaxCandidates);
+    }
+
+    // Farther than a third of the query length is not a plausible typo.
+    int32_t max_distance = std::max<int32_t>(2, query.size() / 3);
+    // (distance, name index)
+    std::vector<std::pair<int32_t, uint32_t>> ranked;
+    for (auto [shared, index] : candidates) {
+        int32_t distance = EditDistance(query, names_[index]);
+        if (distance <= max_distance) {
+            ranked.emplace_back(distance, index);
+        }
+    }
+    std::sort(ranked.begin(), ranked.end());
+
+    std::vector<uint32_t> suggestions;
+    for (size_t i = 0; i < ranked.size() && i < count; ++i) {
+        suggestions.push_back(ranked[i].second);
+    }
+    return suggestions;
+}
+
+size_t SuggestionIndex::Footprint() const {
+    return sizeof(SuggestionIndex) +
+           names_.capacity() * sizeof(std::string_view) +
+           postings_.capacity() * sizeof(postings_[0]);
+}
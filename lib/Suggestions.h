@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cinttypes>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ArgumentParser {
+
+// Levenshtein distance. Uses Myers' bit-parallel algorithm when the pattern
+// fits into 64 bits and the classic dynamic programming otherwise.
+int32_t EditDistance(std::string_view pattern, std::string_view text);
+
+// Trigram index over argument names used for "did you mean" hints. Only
+// names sharing trigrams with the query are ranked by edit distance, so a
+// lookup does not scan the whole schema.
+class SuggestionIndex {
+   public:
+    void Build(std::span<const std::string_view> names);
+    size_t size() const { return names_.size(); }
+    // Bytes used by the index, including its postings.
+    size_t Footprint() const;
+
+    // Indices of at most count names close to query, nearest first.
+    std::vector<uint32_t> Suggest(std::string_view query, size_t count) const;
+
+   private:
+    std::vector<std::string_view> names_;
+    // (trigram, name index) pairs sorted by trigram.
+    std::vector<std::pair<uint32_t, uint32_t>> postings_;
+};
+
+}  // namespace ArgumentParser
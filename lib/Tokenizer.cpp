@@ -0,0 +1,167 @@
+#include "Tokenizer.h"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace ArgumentParser;
+
+namespace {
+
+enum class Context { kUnquoted, kSingleQuoted, kDoubleQuoted };
+
+bool IsSpace(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+template <Context context>
+bool IsSpecial(char c) {
+    if constexpr (context == Context::kUnquoted) {
+        return IsSpace(c) || c == '\'' || c == '"' || c == '\\';
+    } else if constexpr (context == Context::kSingleQuoted) {
+        return c == '\'';
+    } else {
+        return c == '"' || c == '\\';
+    }
+}
+
+// Returns the first character at or after begin that ends a plain run in the
+// given context, or end.
+template <Context context>
+const char* FindSpecial(const char* begin, const char* end) {
+#if defined(__SSE2__)
+    while (end - begin >= 16) {
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        __m128i mask;
+        if constexpr (context == Context::kUnquoted) {
+            // '\t'..'\r' are contiguous: (c - '\t') saturating-minus 4 is zero
+            // exactly for them.
+            __m128i control = _mm_cmpeq_epi8(
+                _mm_subs_epu8(_mm_sub_epi8(chunk, _mm_set1_epi8('\t')),
+                              _mm_set1_epi8(4)),
+                _mm_setzero_si128());
+            mask = _mm_or_si128(
+                _mm_or_si128(control,
+                             _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' '))),
+                _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\'')),
+                                 _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'))),
+                    _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))));
+        } else if constexpr (context == Context::kSingleQuoted) {
+            mask = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\''));
+        } else {
+            mask = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')),
+                                _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\')));
+        }
+        int bits = _mm_movemask_epi8(mask);
+        if (bits != 0) {
+            return begin + __builtin_ctz(bits);
+        }
+        begin += 16;
+    }
+#endif
+    while (begin < end && !IsSpecial<context>(*begin)) {
+        ++begin;
+    }
+    return begin;
+}
+
+}  // namespace
+
+bool Tokenizer::Tokenize(std::string_view line) {
+    args_.clear();
+    if (capacity_ < line.size()) {
+        buffer_.reset(new char[line.size()]);
+        capacity_ = line.size();
+    }
+
+    const char* input = line.data();
+    const char* end = input + line.size();
+    char* output = buffer_.get();
+    char* token = nullptr;
+    Context context = Context::kUnquoted;
+
+    while (input < end) {
+        const char* special = nullptr;
+        switch (context) {
+            case Context::kUnquoted:
+                special = FindSpecial<Context::kUnquoted>(input, end);
+                break;
+            case Context::kSingleQuoted:
+                special = FindSpecial<Context::kSingleQuoted>(input, end);
+                break;
+            case Context::kDoubleQuoted:
+                special = FindSpecial<Context::kDoubleQuoted>(input, end);
+                break;
+        }
+        if (special != input) {
+            if (token == nullptr) {
+                token = output;
+            }
+            std::memcpy(output, input, special - input);
+            output += special - input;
+            input = special;
+        }
+        if (input == end) {
+            break;
+        }
+
+        char c = *input++;
+        if (context == Context::kSingleQuoted) {
+            context = Context::kUnquoted;
+            continue;
+        }
+        if (c == '\\') {
+            if (input == end) {
+                return false;
+            }
+            char escaped = *input++;
+            if (escaped == '\n' && context == Context::kUnquoted) {
+                continue;
+            }
+            if (token == nullptr) {
+                token = output;
+            }
+            if (context == Context::kDoubleQuoted &&
+                std::string_view("$`\"\\\n").find(escaped) ==
+                    std::string_view::npos) {
+                *output++ = '\\';
+            }
+            if (escaped != '\n' || context == Context::kUnquoted) {
+                *output++ = escaped;
+            }
+            continue;
+        }
+        if (context == Context::kDoubleQuoted) {
+            context = Context::kUnquoted;
+            continue;
+        }
+        if (c == '\'' || c == '"') {
+            if (token == nullptr) {
+                token = output;
+            }
+            context = c == '\'' ? Context::kSingleQuoted
+                                : Context::kDoubleQuoted;
+            continue;
+        }
+        if (token != nullptr) {
+            args_.emplace_back(token, output - token);
+            token = nullptr;
+        }
+    }
+
+    if (context != Context::kUnquoted) {
+        args_.clear();
+        return false;
+    }
+    if (token != nullptr) {
+        args_.emplace_back(token, output - token);
+    }
+    return true;
+}
+
+size_t Tokenizer::Footprint() const {
+    return sizeof(Tokenizer) + capacity_ +
+           args_.capacity() * sizeof(std::string_view);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace ArgumentParser {
+
+// Splits a whole command line into arguments following POSIX shell quoting:
+// whitespace separates arguments, a backslash escapes the next character,
+// single quotes keep everything literally and double quotes only honour
+// backslashes before $, `, ", \ and newline. No expansions are performed.
+//
+// The returned views point into a buffer owned by the tokenizer and stay
+// valid until the next Tokenize call or its destruction.
+class Tokenizer {
+   public:
+    // Returns false if the line ends inside quotes or after a lone backslash.
+    bool Tokenize(std::string_view line);
+
+    std::span<const std::string_view> args() const { return args_; }
+    // Bytes used by the buffer and the argument views.
+    size_t Footprint() const;
+
+   private:
+    std::unique_ptr<char[]> buffer_;
+    size_t capacity_ = 0;
+    std::vector<std::string_view> args_;
+};
+
+}  // namespace ArgumentParser
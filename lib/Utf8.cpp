@@ -0,0 +1,236 @@
+#include "Utf8.h"
+
+#include <cinttypes>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <tmmintrin.h>
+#define ARGPARSER_HAS_SSSE3_KERNEL 1
+#endif
+
+using namespace ArgumentParser;
+
+namespace {
+
+// Decodes one code point at value[i], advancing i. Returns -1 and advances
+// by one byte on malformed input.
+int32_t Decode(std::string_view value, size_t& i) {
+    uint8_t lead = value[i];
+    if (lead < 0x80) {
+        ++i;
+        return lead;
+    }
+    size_t length;
+    int32_t code_point;
+    int32_t min_code_point;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+        code_point = lead & 0x1F;
+        min_code_point = 0x80;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        code_point = lead & 0x0F;
+        min_code_point = 0x800;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        code_point = lead & 0x07;
+        min_code_point = 0x10000;
+    } else {
+        ++i;
+        return -1;
+    }
+    if (i + length > value.size()) {
+        ++i;
+        return -1;
+    }
+    for (size_t k = 1; k < length; ++k) {
+        uint8_t continuation = value[i + k];
+        if ((continuation & 0xC0) != 0x80) {
+            ++i;
+            return -1;
+        }
+        code_point = (code_point << 6) | (continuation & 0x3F);
+    }
+    if (code_point < min_code_point || code_point > 0x10FFFF ||
+        (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+        ++i;
+        return -1;
+    }
+    i += length;
+    return code_point;
+}
+
+size_t CodePointWidth(int32_t c) {
+    if ((c >= 0x0300 && c <= 0x036F) || (c >= 0x1AB0 && c <= 0x1AFF) ||
+        (c >= 0x1DC0 && c <= 0x1DFF) || (c >= 0x200B && c <= 0x200F) ||
+        (c >= 0x20D0 && c <= 0x20FF) || (c >= 0xFE00 && c <= 0xFE0F) ||
+        (c >= 0xFE20 && c <= 0xFE2F)) {
+        return 0;
+    }
+    if ((c >= 0x1100 && c <= 0x115F) || (c >= 0x2E80 && c <= 0x303E) ||
+        (c >= 0x3041 && c <= 0xA4CF) || (c >= 0xAC00 && c <= 0xD7A3) ||
+        (c >= 0xF900 && c <= 0xFAFF) || (c >= 0xFE30 && c <= 0xFE4F) ||
+        (c >= 0xFF00 && c <= 0xFF60) || (c >= 0xFFE0 && c <= 0xFFE6) ||
+        (c >= 0x1F300 && c <= 0x1F64F) || (c >= 0x1F900 && c <= 0x1F9FF) ||
+        (c >= 0x20000 && c <= 0x3FFFD)) {
+        return 2;
+    }
+    return 1;
+}
+
+#if defined(ARGPARSER_HAS_SSSE3_KERNEL)
+
+// Lookup-table validation by Keiser and Lemire, "Validating UTF-8 In Less
+// Than One Instruction Per Byte" (2021). Every error is a property of two
+// consecutive bytes, classified by three nibble lookups whose AND is
+// non-zero exactly on an error; missing or extra continuation bytes of 3-
+// and 4-byte sequences are checked separately.
+constexpr uint8_t kTooShort = 1 << 0;
+constexpr uint8_t kTooLong = 1 << 1;
+constexpr uint8_t kOverlong3 = 1 << 2;
+constexpr uint8_t kTooLarge = 1 << 3;
+constexpr uint8_t kSurrogate = 1 << 4;
+constexpr uint8_t kOverlong2 = 1 << 5;
+constexpr uint8_t kTooLarge1000 = 1 << 6;
+constexpr uint8_t kOverlong4 = 1 << 6;
+constexpr uint8_t kTwoConts = 1 << 7;
+constexpr uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+
+#define ARGPARSER_SSSE3 __attribute__((target("ssse3")))
+
+ARGPARSER_SSSE3 __m128i Lookup(__m128i table, __m128i nibbles) {
+    return _mm_shuffle_epi8(table, nibbles);
+}
+
+ARGPARSER_SSSE3 __m128i HighNibbles(__m128i value) {
+    return _mm_and_si128(_mm_srli_epi16(value, 4), _mm_set1_epi8(0x0F));
+}
+
+ARGPARSER_SSSE3 __m128i CheckBlock(__m128i input, __m128i previous) {
+    const __m128i byte_1_high_table = _mm_setr_epi8(
+        kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+        kTooLong, kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+        kTooShort | kOverlong2, kTooShort,
+        kTooShort | kOverlong3 | kSurrogate,
+        kTooShort | kTooLarge | kTooLarge1000 | kOverlong4);
+    const __m128i byte_1_low_table = _mm_setr_epi8(
+        kCarry | kOverlong3 | kOverlong2 | kOverlong4, kCarry | kOverlong2,
+        kCarry, kCarry, kCarry | kTooLarge, kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+        kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000);
+    const __m128i byte_2_high_table = _mm_setr_epi8(
+        kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+        kTooShort, kTooShort,
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 |
+            kOverlong4,
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge, kTooShort,
+        kTooShort, kTooShort, kTooShort);
+
+    __m128i previous_1 = _mm_alignr_epi8(input, previous, 15);
+    __m128i special_cases = _mm_and_si128(
+        _mm_and_si128(Lookup(byte_1_high_table, HighNibbles(previous_1)),
+                      Lookup(byte_1_low_table,
+                             _mm_and_si128(previous_1, _mm_set1_epi8(0x0F)))),
+        Lookup(byte_2_high_table, HighNibbles(input)));
+
+    __m128i previous_2 = _mm_alignr_epi8(input, previous, 14);
+    __m128i previous_3 = _mm_alignr_epi8(input, previous, 13);
+    __m128i is_third_byte =
+        _mm_subs_epu8(previous_2, _mm_set1_epi8(static_cast<char>(0xE0 - 1)));
+    __m128i is_fourth_byte =
+        _mm_subs_epu8(previous_3, _mm_set1_epi8(static_cast<char>(0xF0 - 1)));
+    __m128i must_be_continuation = _mm_and_si128(
+        _mm_cmpgt_epi8(_mm_or_si128(is_third_byte, is_fourth_byte),
+                       _mm_setzero_si128()),
+        _mm_set1_epi8(static_cast<char>(0x80)));
+    return _mm_xor_si128(must_be_continuation, special_cases);
+}
+
+// Non-zero if the block ends in the middle of a multi-byte sequence.
+ARGPARSER_SSSE3 __m128i IncompleteTail(__m128i input) {
+    const __m128i max_value = _mm_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1),
+        static_cast<char>(0xC0 - 1));
+    return _mm_subs_epu8(input, max_value);
+}
+
+struct Ssse3State {
+    __m128i error;
+    __m128i previous;
+    __m128i incomplete;
+};
+
+ARGPARSER_SSSE3 void CheckInput(Ssse3State& state, __m128i input) {
+    if (_mm_movemask_epi8(input) == 0) {
+        state.error = _mm_or_si128(state.error, state.incomplete);
+        state.incomplete = _mm_setzero_si128();
+    } else {
+        state.error =
+            _mm_or_si128(state.error, CheckBlock(input, state.previous));
+        state.incomplete = IncompleteTail(input);
+    }
+    state.previous = input;
+}
+
+ARGPARSER_SSSE3 bool IsValidUtf8Ssse3(std::string_view value) {
+    Ssse3State state = {_mm_setzero_si128(), _mm_setzero_si128(),
+                        _mm_setzero_si128()};
+    size_t i = 0;
+    for (; i + 16 <= value.size(); i += 16) {
+        CheckInput(state, _mm_loadu_si128(
+                              reinterpret_cast<const __m128i*>(value.data() + i)));
+    }
+    if (i < value.size()) {
+        // Zero padding is ASCII, so a truncated sequence is reported.
+        alignas(16) char tail[16] = {};
+        std::memcpy(tail, value.data() + i, value.size() - i);
+        CheckInput(state,
+                   _mm_load_si128(reinterpret_cast<const __m128i*>(tail)));
+    }
+    __m128i error = _mm_or_si128(state.error, state.incomplete);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) ==
+           0xFFFF;
+}
+
+#undef ARGPARSER_SSSE3
+
+#endif
+
+}  // namespace
+
+bool ArgumentParser::IsValidUtf8Scalar(std::string_view value) {
+    size_t i = 0;
+    while (i < value.size()) {
+        if (Decode(value, i) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ArgumentParser::IsValidUtf8(std::string_view value) {
+#if defined(ARGPARSER_HAS_SSSE3_KERNEL)
+    static const bool has_ssse3 = __builtin_cpu_supports("ssse3");
+    if (has_ssse3) {
+        return IsValidUtf8Ssse3(value);
+    }
+#endif
+    return IsValidUtf8Scalar(value);
+}
+
+size_t ArgumentParser::DisplayWidth(std::string_view value) {
+    size_t width = 0;
+    size_t i = 0;
+    while (i < value.size()) {
+        int32_t code_point = Decode(value, i);
+        width += code_point < 0 ? 1 : CodePointWidth(code_point);
+    }
+    return width;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace ArgumentParser {
+
+// UTF-8 validation (RFC 3629: no overlongs, surrogates or code points above
+// U+10FFFF). Uses a vectorized kernel when the CPU supports SSSE3.
+bool IsValidUtf8(std::string_view value);
+bool IsValidUtf8Scalar(std::string_view value);
+
+// Number of terminal columns value occupies: wide East Asian characters and
+// emoji count as two, combining marks as zero. Bytes that are not valid
+// UTF-8 count as one column each.
+size_t DisplayWidth(std::string_view value);
+
+}  // namespace ArgumentParser
@@ -0,0 +1,101 @@
+#include <lib/ArgParser.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace ArgumentParser;
+
+// Counts every allocation of this binary, so these tests live apart from
+// argparser_tests. All unaligned replaceable forms are provided to keep new
+// and delete matched; the aligned ones keep their own matched defaults.
+namespace {
+std::atomic<size_t> allocations_count{0};
+
+void* Allocate(size_t size) {
+    ++allocations_count;
+    if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+}  // namespace
+
+void* operator new(size_t size) { return Allocate(size); }
+
+void* operator new[](size_t size) { return Allocate(size); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    ++allocations_count;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    ++allocations_count;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+
+void operator delete[](void* pointer, size_t) noexcept { std::free(pointer); }
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
+
+
+TEST(ArgParserTestSuite, StringViewNoAllocationTest) {
+    ArgParser parser("My Parser");
+    parser.AddStringArgument("paths").MultiValue(1).Positional();
+    const size_t kPathsCount = 1000000;
+    std::vector<std::string> args = {"app"};
+    for (size_t i = 0; i < kPathsCount; ++i) {
+        args.push_back("/data/file" + std::to_string(i));
+    }
+
+    ASSERT_TRUE(parser.Parse(args));
+    size_t allocations_before = allocations_count;
+    size_t total_size = 0;
+    for (std::string_view path : parser.GetStringValues("paths")) {
+        total_size += path.size();
+    }
+    ASSERT_EQ(allocations_count, allocations_before);
+    ASSERT_EQ(parser.GetStringValues("paths").size(), kPathsCount);
+    ASSERT_GT(total_size, kPathsCount);
+}
+
+
+TEST(ArgParserTestSuite, LazyPositionalArgvTest) {
+    const size_t kFilesCount = 1000000;
+    std::vector<std::string> storage;
+    storage.reserve(kFilesCount + 1);
+    storage.push_back("app");
+    for (size_t i = 0; i < kFilesCount; ++i) {
+        storage.push_back("file" + std::to_string(i));
+    }
+    std::vector<char*> argv;
+    for (std::string& arg : storage) {
+        argv.push_back(arg.data());
+    }
+
+    ArgParser parser("My Parser");
+    parser.AddStringArgument("files").MultiValue(1).Positional().Lazy();
+    size_t allocations_before = allocations_count;
+    ASSERT_TRUE(parser.Parse(argv.size(), argv.data()));
+    size_t count = 0;
+    for (std::string_view file : parser.GetPositionalRange("files")) {
+        count += !file.empty();
+    }
+    ASSERT_LT(allocations_count - allocations_before, 16);
+    ASSERT_EQ(count, kFilesCount);
+}
@@ -1,7 +1,33 @@
 #include <lib/ArgParser.h>
+#include <lib/Completion.h>
+#include <lib/FlagRegistry.h>
+#include <lib/MappedFile.h>
+#include <lib/Parallel.h>
+#include <lib/Suggestions.h>
+#include <lib/Tokenizer.h>
+#include <lib/Utf8.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
 #include <sstream>
+#include <thread>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__) && defined(__LP64__)
+#include <elf.h>
+#endif
 
 using namespace ArgumentParser;
 
@@ -180,3 +206,1071 @@ TEST(ArgParserTestSuite, HelpStringTest) {
     //     "-h, --help Display this help and exit\n"
     // );
 }
+
+
+TEST(ArgParserTestSuite, MemoryFootprintTest) {
+    ArgParser parser("My Parser");
+    const int32_t kArgumentsCount = 3000;
+    for (int32_t i = 0; i < kArgumentsCount; ++i) {
+        std::string name = "option-number-" + std::to_string(i);
+        switch (i % 3) {
+            case 0:
+                parser.AddIntArgument(name, "Some Number");
+                break;
+            case 1:
+                parser.AddStringArgument(name, "File path for input file");
+                break;
+            default:
+                parser.AddFlag(name, "Use some logic");
+                break;
+        }
+    }
+
+    ASSERT_EQ(parser.GetArgument("option-number-42")->name(), "option-number-42");
+    ASSERT_EQ(parser.GetArgument("option-number-0")->description().data(),
+              parser.GetArgument("option-number-3")->description().data());
+    size_t bytes_per_argument = parser.MemoryFootprint() / kArgumentsCount;
+    RecordProperty("bytes_per_argument", std::to_string(bytes_per_argument));
+    std::cout << "bytes per argument: " << bytes_per_argument << std::endl;
+
+    // On top of the argument objects only the descriptor, the sorted index
+    // entry and the pooled name are allowed, each with 2x growth slack;
+    // descriptions are shared.
+    size_t objects = (sizeof(IntArgument) + sizeof(StringArgument) + sizeof(FlagArgument)) / 3;
+    size_t name_size = std::string_view("option-number-1000").size();
+    ASSERT_LE(bytes_per_argument,
+              objects + 2 * (sizeof(ArgumentDescriptor) + sizeof(uint32_t) + name_size));
+
+    // Indexes built on demand are counted with their heap data: every name
+    // has a view and at least one (trigram, index) posting.
+    size_t footprint = parser.MemoryFootprint();
+    ASSERT_FALSE(parser.Suggest("option-numbr-42").empty());
+    size_t with_suggestions = parser.MemoryFootprint();
+    ASSERT_GE(with_suggestions - footprint,
+              kArgumentsCount * (sizeof(std::string_view) + 2 * sizeof(uint32_t)));
+    parser.AddMutuallyExclusive({"option-number-0", "option-number-2999"});
+    ASSERT_GT(parser.MemoryFootprint(), with_suggestions);
+}
+
+
+TEST(ArgParserTestSuite, UnsetStringValueTest) {
+    ArgParser parser("My Parser");
+    parser.AddHelp('h', "help", "Some Description about program");
+    parser.AddStringArgument("name");
+    parser.AddStringArgument("paths").MultiValue();
+
+    ASSERT_TRUE(parser.Parse(SplitString("app --help")));
+    ASSERT_EQ(parser.GetStringValue("name"), "");
+    ASSERT_EQ(parser.GetStringView("name"), "");
+    ASSERT_TRUE(parser.GetStringValues("name").empty());
+    ASSERT_THROW(parser.GetStringView("paths"), std::out_of_range);
+}
+
+
+TEST(ArgParserTestSuite, ReusedParserMemoryTest) {
+    ArgParser parser("My Parser");
+    parser.AddStringArgument("name").Default("nobody");
+    parser.AddStringArgument("mode").Choices({"fast", "slow"}).Default("fast");
+    std::vector<std::string> args = {"app", "--name=" + std::string(100, 'x'), "--mode=slow"};
+
+    ASSERT_TRUE(parser.Parse(args));
+    size_t footprint = parser.MemoryFootprint();
+    for (int32_t i = 0; i < 10000; ++i) {
+        args[1].back() = 'a' + i % 26;
+        ASSERT_TRUE(parser.Parse(args));
+    }
+    ASSERT_EQ(parser.MemoryFootprint(), footprint);
+    ASSERT_EQ(parser.GetStringView("name"), std::string(99, 'x') + char('a' + 9999 % 26));
+
+    // Values of an earlier Parse do not outlive the next one.
+    ASSERT_TRUE(parser.Parse(SplitString("app")));
+    ASSERT_EQ(parser.GetStringView("name"), "nobody");
+    ASSERT_EQ(parser.GetStringView("mode"), "fast");
+    ASSERT_FALSE(parser.GetArgument("name")->is_set());
+}
+
+
+TEST(ArgParserTestSuite, StringViewTest) {
+    ArgParser parser("My Parser");
+    std::vector<std::string> values;
+    parser.AddStringArgument('i', "input").MultiValue().StoreValues(values);
+    parser.AddStringArgument("output").Default("result.txt");
+
+    ASSERT_TRUE(parser.Parse(SplitString("app --input=a.txt -i=b.txt --input=c.txt")));
+    ASSERT_EQ(parser.GetStringView("output"), "result.txt");
+    ASSERT_EQ(parser.GetStringView("input", 1), "b.txt");
+    std::span<const std::string_view> views = parser.GetStringValues("input");
+    ASSERT_EQ(views.size(), 3);
+    ASSERT_EQ(views[2], "c.txt");
+    ASSERT_EQ(values[0], "a.txt");
+}
+
+
+TEST(ArgParserTestSuite, ParallelConversionTest) {
+    const size_t kValuesCount = 2000000;
+    std::vector<std::string> args = {"app", "--values"};
+    for (size_t i = 0; i < kValuesCount; ++i) {
+        args.push_back(std::to_string(i * 7 % 100003));
+    }
+
+    std::vector<int> serial_values;
+    ArgParser serial("Serial Parser");
+    serial.AddIntArgument("values").MultiValue().StoreValues(serial_values);
+    auto serial_start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(serial.Parse(args));
+    auto serial_time = std::chrono::steady_clock::now() - serial_start;
+
+    std::vector<int> parallel_values;
+    ArgParser parallel("Parallel Parser");
+    parallel.ParallelConversion(1024);
+    parallel.AddIntArgument("values").MultiValue().StoreValues(parallel_values);
+    auto parallel_start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(parallel.Parse(args));
+    auto parallel_time = std::chrono::steady_clock::now() - parallel_start;
+
+    ASSERT_EQ(serial_values, parallel_values);
+    std::cout << "serial: "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(serial_time).count()
+              << " ms, parallel: "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(parallel_time).count()
+              << " ms" << std::endl;
+}
+
+
+TEST(ArgParserTestSuite, ParallelConversionErrorTest) {
+    std::vector<std::string> args = {"app", "--values"};
+    for (size_t i = 0; i < 100000; ++i) {
+        args.push_back(std::to_string(i));
+    }
+    args[2 + 90000] = "bad";
+    args[2 + 70000] = "worse";
+
+    std::vector<int> values;
+    ArgParser parser("My Parser");
+    parser.ParallelConversion(1024, 8);
+    parser.AddIntArgument("values").MultiValue().StoreValues(values);
+
+    ASSERT_THROW(parser.Parse(args), std::invalid_argument);
+    ASSERT_EQ(values.size(), 70000);
+    ASSERT_EQ(values.back(), 69999);
+}
+
+
+TEST(ArgParserTestSuite, ParseIntTest) {
+    int32_t result = 0;
+    ASSERT_EQ(ParseInt(" \t+42", result), std::errc());
+    ASSERT_EQ(result, 42);
+    ASSERT_EQ(ParseInt("+-1", result), std::errc::invalid_argument);
+    // Bytes above 0x7f are not spaces, whatever the sign of char.
+    ASSERT_EQ(ParseInt("\xC2\xA0" "5", result), std::errc::invalid_argument);
+    ASSERT_THROW(ParseInt("\xFF"), std::invalid_argument);
+    ASSERT_THROW(ParseInt("99999999999"), std::out_of_range);
+}
+
+
+TEST(ArgParserTestSuite, ParseAfterConversionErrorTest) {
+    ArgParser parser("My Parser");
+    parser.AddStringArgument("paths").MultiValue().Positional();
+    parser.AddIntArgument("number").Default(0);
+
+    ASSERT_THROW(parser.Parse(SplitString("app a.txt b.txt c.txt --number=x")),
+                 std::invalid_argument);
+    ASSERT_TRUE(parser.Parse(SplitString("app d.txt --number=1")));
+    ASSERT_EQ(parser.GetIntValue("number"), 1);
+    ASSERT_EQ(parser.GetStringValues("paths").back(), "d.txt");
+}
+
+
+TEST(ArgParserTestSuite, ParallelForPoolTest) {
+    std::atomic<size_t> sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> callers;
+    for (size_t caller = 0; caller < 4; ++caller) {
+        callers.emplace_back([&sum] {
+            for (size_t call = 0; call < 500; ++call) {
+                ParallelFor(64, 4, [&sum](size_t task) { sum += task; });
+            }
+        });
+    }
+    for (std::thread& caller : callers) {
+        caller.join();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    ASSERT_EQ(sum, 4 * 500 * (63 * 64 / 2));
+    std::cout << "ParallelFor: "
+              << std::chrono::duration<double, std::micro>(elapsed).count() / 2000
+              << " us per call on the shared pool" << std::endl;
+}
+
+
+TEST(ArgParserTestSuite, ParallelStringConversionTest) {
+    std::vector<std::string> args = {"app"};
+    for (size_t i = 0; i < 100000; ++i) {
+        args.push_back("file" + std::to_string(i));
+    }
+
+    std::vector<std::string> values;
+    ArgParser parser("My Parser");
+    parser.ParallelConversion(1024);
+    parser.AddStringArgument("files").MultiValue().Positional().StoreValues(values);
+
+    ASSERT_TRUE(parser.Parse(args));
+    ASSERT_EQ(values.size(), 100000);
+    ASSERT_EQ(values[12345], "file12345");
+    ASSERT_EQ(parser.GetStringView("files", 99999), "file99999");
+}
+
+
+TEST(ArgParserTestSuite, TokenizerQuotingTest) {
+    Tokenizer tokenizer;
+    ASSERT_TRUE(tokenizer.Tokenize(
+        "app  --name='John Smith' \"a \\\"b\\\" \\c\" x\\ y '' -f\t--path=\"$HOME\"/bin"));
+    std::vector<std::string_view> expected = {
+        "app", "--name=John Smith", "a \"b\" \\c", "x y", "", "-f", "--path=$HOME/bin"};
+    ASSERT_EQ(std::vector<std::string_view>(tokenizer.args().begin(), tokenizer.args().end()),
+              expected);
+
+    ASSERT_FALSE(tokenizer.Tokenize("app 'unterminated"));
+    ASSERT_FALSE(tokenizer.Tokenize("app \"unterminated"));
+    ASSERT_FALSE(tokenizer.Tokenize("app trailing\\"));
+}
+
+
+TEST(ArgParserTestSuite, ParseCommandLineTest) {
+    ArgParser parser("My Parser");
+    parser.AddStringArgument('o', "output");
+    parser.AddStringArgument("files").MultiValue().Positional();
+
+    ASSERT_TRUE(parser.ParseCommandLine("app -o='my dir/out.txt' \"first file\" second\\ file"));
+    ASSERT_EQ(parser.GetStringValue("output"), "my dir/out.txt");
+    ASSERT_EQ(parser.GetStringValue("files", 0), "first file");
+    ASSERT_EQ(parser.GetStringValue("files", 1), "second file");
+    ASSERT_FALSE(parser.ParseCommandLine("app -o='oops"));
+}
+
+
+TEST(ArgParserTestSuite, TokenizerBenchmarkTest) {
+    std::string line = "app";
+    while (line.size() < 8 * 1024 * 1024) {
+        line += " --input=/very/long/path/to/some/input/file" + std::to_string(line.size());
+        line += "\t-v\n42";
+    }
+
+    auto stream_start = std::chrono::steady_clock::now();
+    std::vector<std::string> expected = SplitString(line);
+    auto stream_time = std::chrono::steady_clock::now() - stream_start;
+
+    Tokenizer tokenizer;
+    auto tokenizer_start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(tokenizer.Tokenize(line));
+    auto tokenizer_time = std::chrono::steady_clock::now() - tokenizer_start;
+
+    ASSERT_EQ(tokenizer.args().size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(tokenizer.args()[i], expected[i]);
+    }
+    std::cout << "istringstream: "
+              << std::chrono::duration_cast<std::chrono::microseconds>(stream_time).count()
+              << " us, tokenizer: "
+              << std::chrono::duration_cast<std::chrono::microseconds>(tokenizer_time).count()
+              << " us for " << line.size() << " bytes" << std::endl;
+}
+
+
+ARGPARSER_DEFINE_INT(test_workers, 4, "Worker threads");
+ARGPARSER_DEFINE_FLAG(test_verbose, false, "Verbose logging");
+ARGPARSER_DEFINE_STRING(test_mode, "fast", "Mode");
+
+
+// The only test touching the global registry; it puts the declared values
+// back, so it does not depend on test order or repetition.
+TEST(ArgParserTestSuite, FlagMacrosTest) {
+    ArgParser parser("My Parser");
+    FlagRegistry::Global().Register(parser);
+    ASSERT_NE(parser.HelpDescription().find("Worker threads"), std::string::npos);
+
+    ASSERT_TRUE(parser.Parse(SplitString("app --test_workers=16 --test_verbose --test_mode=slow")));
+    FlagRegistry::Global().Publish(parser);
+    int32_t workers = FLAGS_test_workers.Get();
+    bool verbose = FLAGS_test_verbose.Get();
+    std::string mode = FLAGS_test_mode.Get();
+
+    ArgParser defaults("My Parser");
+    FlagRegistry::Global().Register(defaults);
+    ASSERT_TRUE(defaults.Parse(
+        SplitString("app --test_workers=4 --test_verbose=false --test_mode=fast")));
+    FlagRegistry::Global().Publish(defaults);
+
+    ASSERT_EQ(workers, 16);
+    ASSERT_TRUE(verbose);
+    ASSERT_EQ(mode, "slow");
+    ASSERT_EQ(FLAGS_test_workers.Get(), 4);
+}
+
+
+TEST(ArgParserTestSuite, FlagRegistryTest) {
+    FlagRegistry registry;
+    Flag<int32_t>& workers = registry.DefineInt("workers", 4, "Worker threads");
+    Flag<bool>& verbose = registry.DefineFlag("verbose", false, "Verbose logging");
+    Flag<std::string>& mode = registry.DefineString("mode", "fast", "Mode");
+    Flag<bool>& color = registry.DefineFlag("color", true, "Colored output");
+
+    ArgParser parser("My Parser");
+    registry.Register(parser);
+    ASSERT_TRUE(parser.Parse(SplitString("app --workers=16 --verbose")));
+    registry.Publish(parser);
+    ASSERT_EQ(workers.Get(), 16);
+    ASSERT_TRUE(verbose.Get());
+    ASSERT_EQ(mode.Get(), "fast");
+
+    std::string path = (std::filesystem::temp_directory_path() / "argparser_flags.txt").string();
+    {
+        std::ofstream file(path);
+        file << "# reloaded values\n--mode='slow and steady'\n--verbose=false\n";
+    }
+    ASSERT_TRUE(registry.Reload(path));
+    ASSERT_EQ(workers.Get(), 16);
+    ASSERT_FALSE(verbose.Get());
+    ASSERT_EQ(mode.Get(), "slow and steady");
+
+    {
+        std::ofstream file(path);
+        file << "--workers=many\n";
+    }
+    ASSERT_FALSE(registry.Reload(path));
+    ASSERT_EQ(workers.Get(), 16);
+    std::filesystem::remove(path);
+
+    ArgParser toggle("My Parser");
+    registry.Register(toggle);
+    ASSERT_NE(toggle.HelpDescription().find("Colored output, (default true)"), std::string::npos);
+    ASSERT_TRUE(toggle.Parse(SplitString("app --color")));
+    registry.Publish(toggle);
+    ASSERT_FALSE(color.Get());
+}
+
+
+TEST(ArgParserTestSuite, FlagRegistryReloadTwiceTest) {
+    FlagRegistry registry;
+    Flag<bool>& verbose = registry.DefineFlag("verbose", false, "Verbose logging");
+    Flag<bool>& color = registry.DefineFlag("color", true, "Colored output");
+    Flag<int32_t>& workers = registry.DefineInt("workers", 4, "Worker threads");
+
+    std::string path = (std::filesystem::temp_directory_path() / "argparser_twice.txt").string();
+    std::ofstream(path) << "--verbose --color --workers=8\n";
+    for (int32_t i = 0; i < 4; ++i) {
+        ASSERT_TRUE(registry.Reload(path));
+        ASSERT_TRUE(verbose.Get());
+        ASSERT_FALSE(color.Get());
+        ASSERT_EQ(workers.Get(), 8);
+    }
+
+    ArgParser parser("My Parser");
+    registry.Register(parser);
+    ASSERT_NE(parser.HelpDescription().find("Colored output, (default true)"), std::string::npos);
+    std::filesystem::remove(path);
+}
+
+
+TEST(ArgParserTestSuite, FlagRegistryConcurrentReadTest) {
+    FlagRegistry registry;
+    Flag<int32_t>& test_workers = registry.DefineInt("test_workers", 4);
+    Flag<std::string>& test_mode = registry.DefineString("test_mode", "fast");
+    std::string path = (std::filesystem::temp_directory_path() / "argparser_reload.txt").string();
+    const int32_t kReaders = std::max(4u, std::thread::hardware_concurrency());
+
+    // Reads per millisecond by all readers together while 100 reloads run.
+    // Every reader copies into its own buffer, as a hot path would.
+    std::atomic<bool> is_consistent = true;
+    auto measure = [&](auto read, auto publish) {
+        std::atomic<bool> is_running = true;
+        std::atomic<size_t> reads = 0;
+        std::vector<std::thread> readers;
+        for (int32_t i = 0; i < kReaders; ++i) {
+            readers.emplace_back([&] {
+                std::string mode;
+                size_t local_reads = 0;
+                while (is_running.load(std::memory_order_relaxed)) {
+                    int32_t workers = read(mode);
+                    if (workers <= 0 || (mode != "fast" && !mode.starts_with("mode"))) {
+                        is_consistent = false;
+                    }
+                    ++local_reads;
+                }
+                reads += local_reads;
+            });
+        }
+        auto start = std::chrono::steady_clock::now();
+        bool is_reloaded = true;
+        for (int32_t i = 1; i <= 100; ++i) {
+            {
+                std::ofstream file(path);
+                file << "--test_workers=" << i << " --test_mode=mode" << i << "\n";
+            }
+            is_reloaded = registry.Reload(path) && is_reloaded;
+            publish();
+        }
+        is_running = false;
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+        EXPECT_TRUE(is_reloaded);
+        double milliseconds =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                .count();
+        return reads / milliseconds;
+    };
+
+    double flag_rate = measure(
+        [&](std::string& mode) {
+            test_mode.Get(mode);
+            return test_workers.Get();
+        },
+        [] {});
+
+    // Baseline: the same values behind a mutex, updated after each reload.
+    std::mutex mutex;
+    int32_t workers = 4;
+    std::string mode = "fast";
+    double mutex_rate = measure(
+        [&](std::string& value) {
+            std::lock_guard<std::mutex> lock(mutex);
+            value.assign(mode);
+            return workers;
+        },
+        [&] {
+            std::lock_guard<std::mutex> lock(mutex);
+            workers = test_workers.Get();
+            mode = test_mode.Get();
+        });
+
+    ASSERT_TRUE(is_consistent);
+    ASSERT_EQ(test_workers.Get(), 100);
+    ASSERT_EQ(test_mode.Get(), "mode100");
+    std::cout << "reads per ms during reloads, " << kReaders << " readers on "
+              << std::thread::hardware_concurrency() << " cores: " << flag_rate
+              << " registry, " << mutex_rate << " mutex" << std::endl;
+    if (std::thread::hardware_concurrency() >= 4) {
+        // The mutex serializes the readers while the flag reads run side by
+        // side, so contention shows up as a clear gap.
+        EXPECT_GT(flag_rate, 2 * mutex_rate);
+    } else {
+        // Too few cores for readers to contend; the flag must keep up.
+        EXPECT_GT(flag_rate, mutex_rate / 2);
+    }
+    std::filesystem::remove(path);
+}
+
+
+TEST(ArgParserTestSuite, ConstraintsTest) {
+    ArgParser parser("My Parser");
+    parser.AddFlag('a', "json");
+    parser.AddFlag('b', "xml");
+    parser.AddStringArgument("user").Default("");
+    parser.AddStringArgument("password").Default("");
+    parser.AddStringArgument("output").Default("");
+    parser.AddFlag("compress");
+    parser.AddMutuallyExclusive({"json", "xml"})
+        .AddRequiredTogether({"user", "password"})
+        .AddAtLeastOne({"json", "xml"})
+        .AddDependency("compress", "output");
+
+    ASSERT_TRUE(parser.Parse(SplitString("app --json --user=me --password=secret")));
+    ASSERT_TRUE(parser.Errors().empty());
+
+    ASSERT_FALSE(parser.Parse(SplitString("app -ab --user=me --compress")));
+    ASSERT_EQ(parser.Errors().size(), 3);
+    ASSERT_EQ(parser.Errors()[0].kind, ParseError::Kind::kConstraint);
+    ASSERT_EQ(parser.Errors()[0].message, "Arguments --json, --xml are mutually exclusive");
+    ASSERT_EQ(parser.Errors()[1].argument, "user");
+    ASSERT_EQ(parser.Errors()[2].message, "Argument --compress requires --output");
+
+    ASSERT_FALSE(parser.Parse(SplitString("app")));
+    ASSERT_EQ(parser.Errors().size(), 1);
+    ASSERT_EQ(parser.Errors()[0].message, "At least one of --json, --xml is required");
+    ASSERT_NE(parser.HelpDescription().find("At least one of --json, --xml is required"),
+              std::string::npos);
+
+    ASSERT_THROW(parser.AddMutuallyExclusive({"json", "yaml"}), std::runtime_error);
+}
+
+
+TEST(ArgParserTestSuite, ConstraintsScaleTest) {
+    ArgParser parser("My Parser");
+    const int32_t kArgumentsCount = 4000;
+    std::vector<std::string> args = {"app"};
+    for (int32_t i = 0; i < kArgumentsCount; ++i) {
+        parser.AddFlag("flag" + std::to_string(i));
+        if (i % 2 == 0) {
+            args.push_back("--flag" + std::to_string(i));
+        }
+    }
+    for (int32_t i = 0; i + 3 < kArgumentsCount; i += 8) {
+        std::string name = "flag" + std::to_string(i);
+        parser.AddMutuallyExclusive({name, "flag" + std::to_string(i + 1)});
+        parser.AddDependency(name, "flag" + std::to_string(i + 2));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(parser.Parse(args));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "1000 rules over " << kArgumentsCount << " arguments: "
+              << std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()
+              << " us" << std::endl;
+}
+
+
+TEST(ArgParserTestSuite, LazyPositionalTest) {
+    ArgParser parser("My Parser");
+    parser.AddIntArgument('j', "jobs").Default(1);
+    parser.AddStringArgument('o', "output").Default("");
+    parser.AddFlag('v', "verbose");
+    parser.AddStringArgument("files").MultiValue(1).Positional().Lazy();
+
+    std::vector<std::string> args = SplitString("app -j 4 --output out -o=x a.txt b.txt c.txt d.txt e.txt -v");
+    ASSERT_TRUE(parser.Parse(args));
+    ASSERT_EQ(parser.GetIntValue("jobs"), 4);
+    ASSERT_EQ(parser.GetStringValue("output"), "x");
+
+    std::vector<std::string_view> files;
+    for (std::string_view file : parser.GetPositionalRange("files")) {
+        files.push_back(file);
+    }
+    std::vector<std::string_view> expected = {"a.txt", "b.txt", "c.txt", "d.txt", "e.txt"};
+    ASSERT_EQ(files, expected);
+    static_assert(std::ranges::forward_range<PositionalRange>);
+    ASSERT_EQ(std::ranges::distance(parser.GetPositionalRange("files")), 5);
+    ASSERT_THROW(parser.GetPositionalRange("output"), std::runtime_error);
+
+    ASSERT_FALSE(parser.Parse(SplitString("app -v")));
+
+    // The range reads a temporary vector the parser has taken over.
+    ASSERT_TRUE(parser.Parse(SplitString("app f.txt g.txt")));
+    files.clear();
+    for (std::string_view file : parser.GetPositionalRange("files")) {
+        files.push_back(file);
+    }
+    ASSERT_EQ(files, (std::vector<std::string_view>{"f.txt", "g.txt"}));
+
+    ArgParser not_positional("My Parser");
+    not_positional.AddStringArgument("files").MultiValue().Lazy();
+    ASSERT_THROW(not_positional.GetPositionalRange("files"), std::runtime_error);
+}
+
+
+TEST(ArgParserTestSuite, LazyPositionalRunsTest) {
+    ArgParser eager("My Parser");
+    eager.AddFlag('v', "verbose");
+    eager.AddStringArgument("files").MultiValue().Positional();
+    ArgParser lazy("My Parser");
+    lazy.AddFlag('v', "verbose");
+    lazy.AddStringArgument("files").MultiValue().Positional().Lazy();
+
+    for (ArgParser* parser : {&eager, &lazy}) {
+        ASSERT_TRUE(parser->Parse(SplitString("app -v a b")));
+        ASSERT_TRUE(parser->Parse(SplitString("app a b -v")));
+        ASSERT_FALSE(parser->Parse(SplitString("app a -v b")));
+    }
+}
+
+
+TEST(ArgParserTestSuite, EditDistanceTest) {
+    ASSERT_EQ(EditDistance("kitten", "sitting"), 3);
+    ASSERT_EQ(EditDistance("flaw", "lawn"), 2);
+    ASSERT_EQ(EditDistance("", "abc"), 3);
+    ASSERT_EQ(EditDistance("same", "same"), 0);
+    std::string long_name(100, 'a');
+    ASSERT_EQ(EditDistance(long_name, long_name + "bb"), 2);
+    ASSERT_EQ(EditDistance(std::string(64, 'x'), std::string(63, 'x') + "y"), 1);
+}
+
+
+TEST(ArgParserTestSuite, SuggestionTest) {
+    ArgParser parser("My Parser");
+    parser.AddStringArgument("output");
+    parser.AddStringArgument("input");
+    parser.AddFlag("verbose");
+    parser.AddFlag("version");
+
+    ASSERT_FALSE(parser.Parse(SplitString("app --verbsoe")));
+    ASSERT_EQ(parser.Errors().size(), 1);
+    ASSERT_EQ(parser.Errors()[0].kind, ParseError::Kind::kUnknownArgument);
+    ASSERT_EQ(parser.Errors()[0].argument, "verbsoe");
+    ASSERT_EQ(parser.Errors()[0].suggestions.front(), "verbose");
+    ASSERT_EQ(parser.Errors()[0].message, "Unknown argument verbsoe, did you mean --verbose?");
+    ASSERT_TRUE(parser.Suggest("completely-different").empty());
+}
+
+
+TEST(ArgParserTestSuite, SuggestionBenchmarkTest) {
+    ArgParser parser("My Parser");
+    const int32_t kNamesCount = 10000;
+    for (int32_t i = 0; i < kNamesCount; ++i) {
+        parser.AddFlag("feature-" + std::to_string(i * 7919 % 100000) + "-enabled");
+    }
+    ASSERT_EQ(parser.Suggest("feature-7919-enabeld", 3).front(), "feature-7919-enabled");
+
+    const int32_t kQueriesCount = 1000;
+    auto start = std::chrono::steady_clock::now();
+    size_t found = 0;
+    for (int32_t i = 0; i < kQueriesCount; ++i) {
+        found += parser.Suggest("featrue-" + std::to_string(i * 7919 % 100000) + "-enabled", 3).size();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    ASSERT_GT(found, 0);
+    std::cout << "suggestion latency over " << kNamesCount << " names: "
+              << std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() / kQueriesCount
+              << " us" << std::endl;
+}
+
+
+TEST(ArgParserTestSuite, FileArgumentTest) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::string key_path = (directory / "argparser_key.pem").string();
+    std::string schema_path = (directory / "argparser_schema.json").string();
+    std::string empty_path = (directory / "argparser_empty.txt").string();
+    std::ofstream(key_path) << "-----BEGIN KEY-----";
+    std::ofstream(schema_path) << "{\"type\": \"object\"}";
+    std::ofstream(empty_path).close();
+
+    ArgParser parser("My Parser");
+    parser.AddFileArgument('k', "key");
+    parser.AddFileArgument("inputs").MultiValue().Prefetch();
+
+    ASSERT_TRUE(parser.Parse(SplitString("app --key=@" + key_path + " --inputs " +
+                                         schema_path + " @" + empty_path)));
+    ASSERT_EQ(parser.GetFileContents("key"), "-----BEGIN KEY-----");
+    ASSERT_EQ(parser.GetFileContents("inputs", 0), "{\"type\": \"object\"}");
+    ASSERT_EQ(parser.GetFileContents("inputs", 1), "");
+    ASSERT_EQ(parser.GetStringValue("key"), "@" + key_path);
+
+    ASSERT_TRUE(parser.Parse(SplitString("app --key=" + schema_path + " --inputs " + key_path)));
+    ASSERT_EQ(parser.GetFileContents("key"), "{\"type\": \"object\"}");
+    ASSERT_EQ(parser.GetStringValues("inputs").size(), 1);
+    ASSERT_EQ(parser.GetFileContents("inputs", 0), "-----BEGIN KEY-----");
+
+    ArgParser lazy("My Parser");
+    lazy.AddFileArgument("key");
+    ASSERT_TRUE(lazy.Parse(SplitString("app --key=@/nonexistent/argparser.pem")));
+    ASSERT_THROW(lazy.GetFileContents("key"), std::runtime_error);
+
+    ArgParser prefetch("My Parser");
+    prefetch.AddFileArgument("inputs").MultiValue().Prefetch();
+    ASSERT_FALSE(prefetch.Parse(SplitString("app --inputs " + key_path + " /nonexistent/argparser.json")));
+    ASSERT_EQ(prefetch.Errors().size(), 1);
+    ASSERT_EQ(prefetch.Errors()[0].kind, ParseError::Kind::kUnreadableFile);
+
+    std::filesystem::remove(key_path);
+    std::filesystem::remove(schema_path);
+    std::filesystem::remove(empty_path);
+}
+
+
+TEST(ArgParserTestSuite, FilePrefetchBenchmarkTest) {
+#if defined(__unix__) || defined(__APPLE__)
+    const int32_t kFiles = 8;
+    const size_t kFileSize = 1024 * 1024;
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::vector<std::string> paths;
+    std::string command_line = "app --inputs";
+    for (int32_t i = 0; i < kFiles; ++i) {
+        paths.push_back((directory / ("argparser_prefetch_" + std::to_string(i))).string());
+        std::ofstream(paths.back()) << std::string(kFileSize, 'a' + i);
+        command_line += " " + paths.back();
+    }
+    // Drops the files from the page cache so every run reads from disk.
+    auto evict = [&paths] {
+        for (const std::string& path : paths) {
+            int descriptor = open(path.c_str(), O_RDONLY);
+            fdatasync(descriptor);
+            posix_fadvise(descriptor, 0, 0, POSIX_FADV_DONTNEED);
+            close(descriptor);
+        }
+    };
+    // (Parse, first pass over the contents) in milliseconds
+    auto run = [&](bool prefetch) {
+        ArgParser parser("My Parser");
+        FileArgument& inputs = parser.AddFileArgument("inputs").MultiValue();
+        if (prefetch) {
+            inputs.Prefetch();
+        }
+        evict();
+        auto start = std::chrono::steady_clock::now();
+        EXPECT_TRUE(parser.ParseCommandLine(command_line));
+        auto parsed = std::chrono::steady_clock::now();
+        size_t sum = 0;
+        for (int32_t i = 0; i < kFiles; ++i) {
+            std::string_view contents = parser.GetFileContents("inputs", i);
+            for (size_t offset = 0; offset < contents.size(); offset += 4096) {
+                sum += contents[offset];
+            }
+        }
+        auto read = std::chrono::steady_clock::now();
+        EXPECT_EQ(sum, kFiles * (kFileSize / 4096) * 'a' + (kFileSize / 4096) * 28);
+        using Milliseconds = std::chrono::duration<double, std::milli>;
+        return std::make_pair(Milliseconds(parsed - start).count(),
+                              Milliseconds(read - parsed).count());
+    };
+
+    auto [lazy_parse, lazy_read] = run(false);
+    auto [prefetch_parse, prefetch_read] = run(true);
+    std::cout << "files: lazy parse " << lazy_parse << " ms + first read " << lazy_read
+              << " ms, prefetch parse " << prefetch_parse << " ms + first read "
+              << prefetch_read << " ms" << std::endl;
+    // Timings depend on the disk and on what else runs, so they are only
+    // reported; the contents are checked in run.
+    for (const std::string& path : paths) {
+        std::filesystem::remove(path);
+    }
+#else
+    GTEST_SKIP() << "posix_fadvise is not available";
+#endif
+}
+
+
+TEST(ArgParserTestSuite, Utf8ValidationTest) {
+    ASSERT_TRUE(IsValidUtf8("plain ascii path/to/file.txt"));
+    ASSERT_TRUE(IsValidUtf8("путь/к/файлу — 文件 😀 in a longer string"));
+    ASSERT_FALSE(IsValidUtf8("overlong \xC0\xAF in the middle of sixteen"));
+    ASSERT_FALSE(IsValidUtf8("surrogate \xED\xA0\x80"));
+    ASSERT_FALSE(IsValidUtf8("too large \xF4\x90\x80\x80"));
+    ASSERT_FALSE(IsValidUtf8("truncated at the very end \xE2\x82"));
+    ASSERT_FALSE(IsValidUtf8("stray continuation \x80 byte"));
+
+    std::mt19937 random(42);
+    const char* pieces[] = {"a", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\x80",
+                            "\xC3", "\xE0\x9F\xBF", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xFF"};
+    for (int32_t i = 0; i < 20000; ++i) {
+        std::string value;
+        int32_t length = random() % 40;
+        for (int32_t k = 0; k < length; ++k) {
+            value += pieces[random() % 8 == 0 ? random() % 10 : random() % 4];
+        }
+        ASSERT_EQ(IsValidUtf8(value), IsValidUtf8Scalar(value)) << value;
+    }
+}
+
+
+TEST(ArgParserTestSuite, Utf8ArgumentTest) {
+    ArgParser parser("My Parser");
+    parser.AddStringArgument("label").Utf8();
+    parser.AddStringArgument("paths").MultiValue().Positional().Utf8();
+
+    ASSERT_TRUE(parser.Parse(SplitString("app --label=метка файл.txt 文件.txt")));
+    ASSERT_EQ(parser.GetStringValue("paths", 1), "文件.txt");
+
+    ArgParser invalid_single("My Parser");
+    invalid_single.AddStringArgument("label").Utf8();
+    ASSERT_FALSE(invalid_single.Parse(std::vector<std::string>{"app", "--label=\xC0\xAF"}));
+    ASSERT_EQ(invalid_single.Errors()[0].kind, ParseError::Kind::kRejectedValue);
+    ASSERT_EQ(invalid_single.Errors()[0].message,
+              "Value \"\\xc0\\xaf\" of argument label is not valid UTF-8");
+    ASSERT_TRUE(invalid_single.Parse(std::vector<std::string>{"app", "--label=метка"}));
+
+    ArgParser invalid_positional("My Parser");
+    invalid_positional.AddStringArgument("paths").MultiValue().Positional().Utf8();
+    ASSERT_FALSE(invalid_positional.Parse(std::vector<std::string>{"app", "ok", "bad\xFF"}));
+
+    ArgParser invalid_lazy("My Parser");
+    invalid_lazy.AddStringArgument("paths").MultiValue().Positional().Lazy().Utf8();
+    ASSERT_FALSE(invalid_lazy.Parse(std::vector<std::string>{"app", "ok", "bad\xFF"}));
+}
+
+
+TEST(ArgParserTestSuite, HelpDisplayWidthTest) {
+    ASSERT_EQ(DisplayWidth("abc"), 3);
+    ASSERT_EQ(DisplayWidth("файл"), 4);
+    ASSERT_EQ(DisplayWidth("文件"), 4);
+    ASSERT_EQ(DisplayWidth("e\xCC\x81"), 1);
+
+    ArgParser parser("My Parser");
+    parser.AddStringArgument('f', "файл", "Входной файл");
+    parser.AddStringArgument("output", "Output file");
+    std::string help = parser.HelpDescription();
+
+    size_t first = help.find("Входной");
+    size_t second = help.find("Output file");
+    size_t first_line = help.rfind('\n', first) + 1;
+    size_t second_line = help.rfind('\n', second) + 1;
+    ASSERT_EQ(DisplayWidth(std::string_view(help).substr(first_line, first - first_line)),
+              DisplayWidth(std::string_view(help).substr(second_line, second - second_line)));
+}
+
+
+TEST(ArgParserTestSuite, Utf8ThroughputTest) {
+    std::string text;
+    while (text.size() < 32 * 1024 * 1024) {
+        text += "--input=/data/проект/文件/report-2024.txt ";
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(IsValidUtf8(text));
+    auto vector_time = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(IsValidUtf8Scalar(text));
+    auto scalar_time = std::chrono::steady_clock::now() - start;
+
+    auto throughput = [&text](auto elapsed) {
+        double seconds = std::chrono::duration<double>(elapsed).count();
+        return text.size() / seconds / 1e9;
+    };
+    std::cout << "UTF-8 validation: " << throughput(vector_time) << " GB/s vectorized, "
+              << throughput(scalar_time) << " GB/s scalar" << std::endl;
+}
+
+
+TEST(ArgParserTestSuite, ChoicesTest) {
+    ArgParser parser("My Parser");
+    parser.AddStringArgument('m', "mode", "Build mode").Choices({"debug", "release"});
+
+    ASSERT_TRUE(parser.Parse(SplitString("app --mode=release")));
+    ASSERT_EQ(parser.GetStringValue("mode"), "release");
+    ASSERT_NE(parser.HelpDescription().find("(one of debug, release)"), std::string::npos);
+
+    ASSERT_FALSE(parser.Parse(SplitString("app -m=fast")));
+    ASSERT_EQ(parser.Errors().size(), 1);
+    ASSERT_EQ(parser.Errors()[0].kind, ParseError::Kind::kRejectedValue);
+    ASSERT_EQ(parser.Errors()[0].message,
+              "Value \"fast\" of argument mode is not one of debug, release");
+
+    ASSERT_TRUE(parser.Parse(SplitString("app -m=debug")));
+    ASSERT_EQ(parser.GetStringValue("mode"), "debug");
+}
+
+
+TEST(ArgParserTestSuite, CompletionTest) {
+    ArgParser parser("My Parser");
+    parser.AddStringArgument('m', "mode", "Build mode").Choices({"debug", "release"});
+    parser.AddIntArgument("jobs", "Parallel jobs");
+    parser.AddFlag('v', "verbose", "Verbose output");
+    parser.AddStringArgument("paths").MultiValue().Positional();
+    std::string index = parser.CompletionIndex();
+
+    std::string out;
+    Complete(index, "--m", out);
+    ASSERT_EQ(out, "--mode\tBuild mode\n"
+                   "--mode=debug\tBuild mode\n"
+                   "--mode=release\tBuild mode\n");
+    out.clear();
+    Complete(index, "--mode=r", out);
+    ASSERT_EQ(out, "--mode=release\tBuild mode\n");
+    out.clear();
+    Complete(index, "-v", out);
+    ASSERT_EQ(out, "-v\tVerbose output\n");
+    out.clear();
+    Complete(index, "--x", out);
+    ASSERT_EQ(out, "");
+
+    std::vector<std::string> args = {"app", "--__complete", "--j"};
+    std::vector<char*> argv;
+    for (std::string& arg : args) {
+        argv.push_back(arg.data());
+    }
+    ASSERT_TRUE(IsCompletionQuery(argv.size(), argv.data()));
+    ASSERT_FALSE(IsCompletionQuery(1, argv.data()));
+
+    std::string path = (std::filesystem::temp_directory_path() / "argparser.completion").string();
+    ASSERT_TRUE(parser.WriteCompletionIndex(path));
+    args = {"app", "--__completion-index", path};
+    argv.clear();
+    for (std::string& arg : args) {
+        argv.push_back(arg.data());
+    }
+    ASSERT_TRUE(IsCompletionIndexRequest(argv.size(), argv.data()));
+    ASSERT_FALSE(IsCompletionQuery(argv.size(), argv.data()));
+    MappedFile written;
+    ASSERT_TRUE(written.Open(path));
+    ASSERT_EQ(written.contents(), index);
+    ASSERT_FALSE(parser.WriteCompletionIndex(path + "/missing/index"));
+
+    std::string bash = parser.CompletionScript(Shell::kBash, "app", path);
+    ASSERT_NE(bash.find("complete -F _app_complete app"), std::string::npos);
+    ASSERT_NE(bash.find("app --__complete '" + path + "'"), std::string::npos);
+    ASSERT_NE(bash.find("compgen -f"), std::string::npos);
+    std::string zsh = parser.CompletionScript(Shell::kZsh, "app", path);
+    ASSERT_NE(zsh.find("compdef _app_complete app"), std::string::npos);
+    std::string fish = parser.CompletionScript(Shell::kFish, "app", path);
+    ASSERT_NE(fish.find("complete -c app -a '(_app_complete)'"), std::string::npos);
+    std::filesystem::remove(path);
+
+    // A quote in the path must not end the quoted word.
+    bash = parser.CompletionScript(Shell::kBash, "app", "/tmp/it's\\dir/index");
+    ASSERT_NE(bash.find("app --__complete '/tmp/it'\\''s\\dir/index'"), std::string::npos);
+    zsh = parser.CompletionScript(Shell::kZsh, "app", "/tmp/it's\\dir/index");
+    ASSERT_NE(zsh.find("app --__complete '/tmp/it'\\''s\\dir/index'"), std::string::npos);
+    fish = parser.CompletionScript(Shell::kFish, "app", "/tmp/it's\\dir/index");
+    ASSERT_NE(fish.find("app --__complete '/tmp/it\\'s\\\\dir/index'"), std::string::npos);
+
+    ArgParser options_only("My Parser");
+    options_only.AddFlag("verbose");
+    ASSERT_EQ(options_only.CompletionScript(Shell::kBash, "app", path).find("compgen -f"),
+              std::string::npos);
+}
+
+
+TEST(ArgParserTestSuite, CompletionLatencyTest) {
+    ArgParser parser("My Parser");
+    const int32_t kArgumentsCount = 5000;
+    for (int32_t i = 0; i < kArgumentsCount; ++i) {
+        parser.AddStringArgument("option-number-" + std::to_string(i), "Some option")
+            .Choices({"first", "second"});
+    }
+    std::string index = parser.CompletionIndex();
+
+    const int32_t kQueries = 1000;
+    std::string out;
+    auto start = std::chrono::steady_clock::now();
+    for (int32_t i = 0; i < kQueries; ++i) {
+        out.clear();
+        Complete(index, "--option-number-" + std::to_string(i * 5 % kArgumentsCount) + "=s",
+                 out);
+        ASSERT_FALSE(out.empty());
+    }
+    double microseconds =
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+            .count() / kQueries;
+    std::cout << "completion query: " << microseconds << " us over " << kArgumentsCount
+              << " options" << std::endl;
+    ASSERT_LT(microseconds, 1000);
+}
+
+
+TEST(ArgParserTestSuite, CompletionEndToEndTest) {
+#if defined(__unix__) || defined(__APPLE__)
+    ArgParser parser("My Parser");
+    const int32_t kArgumentsCount = 5000;
+    for (int32_t i = 0; i < kArgumentsCount; ++i) {
+        parser.AddStringArgument("option-number-" + std::to_string(i), "Some option")
+            .Choices({"first", "second"});
+    }
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::string index = (directory / "argparser_e2e.completion").string();
+    std::string output = (directory / "argparser_e2e.out").string();
+    ASSERT_TRUE(parser.WriteCompletionIndex(index));
+
+    // The same command line the generated shell scripts run on every <TAB>.
+    auto run = [&](const char* path, int32_t count) {
+        std::string program = path;
+        std::string option = std::string(kCompleteOption);
+        std::string word = "--option-number-42=";
+        char* argv[] = {program.data(), option.data(), index.data(), word.data(), nullptr};
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, output.c_str(),
+                                         O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        auto start = std::chrono::steady_clock::now();
+        for (int32_t i = 0; i < count; ++i) {
+            pid_t pid = 0;
+            int status = 0;
+            EXPECT_EQ(posix_spawn(&pid, path, &actions, nullptr, argv, nullptr), 0);
+            waitpid(pid, &status, 0);
+            EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        }
+        posix_spawn_file_actions_destroy(&actions);
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() -
+                                                         start).count() / count;
+    };
+
+    run(STARTUP_MINIMAL_PATH, 1);
+    MappedFile answer;
+    ASSERT_TRUE(answer.Open(output));
+    ASSERT_EQ(answer.contents(), "--option-number-42=first\tSome option\n"
+                                 "--option-number-42=second\tSome option\n");
+
+    // A <TAB> costs at least one process start, which the empty program
+    // measures and the library cannot shorten. With a shared libstdc++ the
+    // dynamic loader adds about half a millisecond on top, so end to end
+    // the 1 ms target holds only for a statically linked C++ runtime; the
+    // check is on the time the query adds to a process start.
+    const int32_t kRuns = 200;
+    double empty = run(STARTUP_EMPTY_PATH, kRuns);
+    double shared_query = run(STARTUP_MINIMAL_PATH, kRuns);
+    double static_query = run(COMPLETION_MINIMAL_PATH, kRuns);
+    std::cout << "completion end to end over " << kArgumentsCount << " options: "
+              << static_query << " us static runtime, " << shared_query
+              << " us shared runtime, " << empty << " us empty program" << std::endl;
+#if !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+    EXPECT_LT(static_query - empty, 1000);
+#endif
+    std::filesystem::remove(index);
+    std::filesystem::remove(output);
+#else
+    GTEST_SKIP() << "posix_spawn is not available";
+#endif
+}
+
+
+#if defined(__linux__) && defined(__LP64__)
+// Bytes of a binary that are loaded at run time, leaving out debug
+// information and symbol tables.
+uint64_t LoadedSize(const char* path) {
+    std::ifstream binary(path, std::ios::binary);
+    Elf64_Ehdr header;
+    binary.read(reinterpret_cast<char*>(&header), sizeof(header));
+    std::vector<Elf64_Shdr> sections(header.e_shnum);
+    binary.seekg(header.e_shoff);
+    binary.read(reinterpret_cast<char*>(sections.data()),
+                sections.size() * sizeof(Elf64_Shdr));
+    uint64_t size = 0;
+    for (const Elf64_Shdr& section : sections) {
+        if ((section.sh_flags & SHF_ALLOC) && section.sh_type != SHT_NOBITS) {
+            size += section.sh_size;
+        }
+    }
+    return size;
+}
+#endif
+
+
+TEST(ArgParserTestSuite, StartupBenchmarkTest) {
+#if defined(__unix__) || defined(__APPLE__)
+    auto run = [](const char* path, int32_t count) {
+        std::string program = path;
+        std::string option = "--input=data.txt";
+        char* argv[] = {program.data(), option.data(), nullptr};
+        auto start = std::chrono::steady_clock::now();
+        for (int32_t i = 0; i < count; ++i) {
+            pid_t pid = 0;
+            int status = 0;
+            EXPECT_EQ(posix_spawn(&pid, path, nullptr, nullptr, argv, nullptr), 0);
+            waitpid(pid, &status, 0);
+            EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        }
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() -
+                                                         start).count() / count;
+    };
+
+    const int32_t kRuns = 200;
+    run(STARTUP_MINIMAL_PATH, 10);
+    double empty = run(STARTUP_EMPTY_PATH, kRuns);
+    double minimal = run(STARTUP_MINIMAL_PATH, kRuns);
+    std::cout << "startup: " << minimal << " us with ArgParser, " << empty
+              << " us empty program" << std::endl;
+    uintmax_t minimal_size = std::filesystem::file_size(STARTUP_MINIMAL_PATH);
+    uintmax_t full_size = std::filesystem::file_size(STARTUP_FULL_PATH);
+    std::cout << "binary size: " << minimal_size << " bytes with ArgParser, " << full_size
+              << " bytes using every feature, "
+              << std::filesystem::file_size(STARTUP_EMPTY_PATH) << " bytes empty program"
+              << std::endl;
+
+    // Nothing in the library may construct the iostream objects: a program
+    // that imports ios_base::Init pays for it on every start.
+    std::ifstream binary(STARTUP_MINIMAL_PATH, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(binary)),
+                         std::istreambuf_iterator<char>());
+    EXPECT_EQ(contents.find("_ZNSt8ios_base4InitC1Ev"), std::string::npos);
+#if defined(__linux__) && defined(__LP64__)
+    // Linked without --gc-sections both programs carry the whole library and
+    // differ by well under 1%; with it the unused help, completion and
+    // constraint code is dropped from startup_minimal. Debug information
+    // is not loaded and is not collected, so it is left out.
+    uint64_t minimal_loaded = LoadedSize(STARTUP_MINIMAL_PATH);
+    uint64_t full_loaded = LoadedSize(STARTUP_FULL_PATH);
+    std::cout << "loaded size: " << minimal_loaded << " bytes with ArgParser, "
+              << full_loaded << " bytes using every feature" << std::endl;
+    EXPECT_LT(minimal_loaded, full_loaded - full_loaded / 10);
+#endif
+#else
+    GTEST_SKIP() << "posix_spawn is not available";
+#endif
+}
@@ -0,0 +1,4 @@
+// Baseline for StartupBenchmarkTest: process startup without the library.
+int main() {
+    return 0;
+}
@@ -0,0 +1,29 @@
+#include <lib/ArgParser.h>
+#include <lib/Completion.h>
+
+#include <cstdio>
+
+// Uses help, completion, constraints, suggestions, command-line strings and
+// file arguments. StartupBenchmarkTest checks that startup_minimal, which
+// uses none of them, links to a smaller binary.
+int main(int argc, char** argv) {
+    ArgumentParser::ArgParser parser("Full");
+    parser.AddHelp('h', "help", "Everything the library offers");
+    parser.AddStringArgument('i', "input", "Input file").Default("-");
+    parser.AddFileArgument('k', "key", "Key file").Prefetch();
+    parser.AddFlag('v', "verbose", "Verbose output");
+    parser.AddFlag('q', "quiet", "Quiet output");
+    parser.AddMutuallyExclusive({"verbose", "quiet"});
+    if (!parser.Parse(argc, argv) ||
+        !parser.ParseCommandLine("--input='data file.txt'")) {
+        return 1;
+    }
+    std::string text = parser.HelpDescription() +
+                       parser.CompletionScript(ArgumentParser::Shell::kBash,
+                                               "full", "full.completion");
+    for (const std::string& name : parser.Suggest("inptu")) {
+        text += name;
+    }
+    std::fwrite(text.data(), 1, text.size(), stdout);
+    return 0;
+}
@@ -0,0 +1,14 @@
+#include <lib/ArgParser.h>
+#include <lib/Completion.h>
+
+// Smallest useful ArgParser program, spawned by StartupBenchmarkTest and
+// CompletionEndToEndTest.
+int main(int argc, char** argv) {
+    if (ArgumentParser::IsCompletionQuery(argc, argv)) {
+        return ArgumentParser::AnswerCompletion(argc, argv);
+    }
+    ArgumentParser::ArgParser parser("Minimal");
+    parser.AddStringArgument('i', "input", "Input file").Default("-");
+    parser.AddFlag('v', "verbose", "Verbose output");
+    return parser.Parse(argc, argv) ? 0 : 1;
+}